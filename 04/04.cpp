@@ -6,6 +6,10 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
+#include "../common/gltrace.h"
+#include "../common/startup-time.h"
+#include "shaders.h"
+
 
 static void glfwErrorCallback(int error, const char *desc) {
     fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
@@ -20,36 +24,13 @@ static GLuint loadShader(const char *fn, GLenum shaderType) {
         exit(1);
     }
 
-    FILE *f = fopen(fn, "r");
-    if (!f) {
-        perror("Failed to load shader file");
-        exit(1);
-    }
-    if (fseek(f, 0, SEEK_END)) {
-        perror("Failed to get file size");
-        exit(1);
-    }
-    GLint size = ftell(f);
-    if (size == -1) {
-        perror("Failed to get file size");
-        exit(1);
-    }
-    rewind(f);
-    char *source = (char*)malloc(size);
-    if (!source) {
-        perror("Failed to allocate source memory");
-        exit(1);
-    }
-    if (fread(source, 1, size, f) != size) {
-        perror("Failed to read file");
-        exit(1);
-    }
-    if (fclose(f))
-        perror("Warning: failed to close source file");
-
-    const GLchar *rosource = source;
-    glShaderSource(shaderID, 1, &rosource, &size);
-    free(source);
+    // Embedded at build time, unless SHADER_DIR says to read it from disk
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    glShaderSource(shaderID, 1, &source, &size);
+    free(allocated);
 
     glCompileShader(shaderID);
 
@@ -325,6 +306,8 @@ static void init(GLFWwindow **window) {
 }
 
 int main() {
+    markMainStart();
+
     GLFWwindow *window;
     init(&window);
 
@@ -337,6 +320,7 @@ int main() {
 
         // Swap buffers
         glfwSwapBuffers(window);
+        reportStartupTime();
         glfwPollEvents();
 
         // Check if the ESC key was pressed or the window was closed
@@ -0,0 +1,637 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "../common/gltrace.h"
+#include "../common/startup-time.h"
+#include "shaders.h"
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+static GLuint loadShader(const char *fn, GLenum shaderType) {
+    printf("Compiling shader '%s'...\n", fn);
+
+    GLuint shaderID = glCreateShader(shaderType);
+    if (!shaderID) {
+        fprintf(stderr, "Failed to create shader\n");
+        exit(1);
+    }
+
+    // Embedded at build time, unless SHADER_DIR says to read it from disk
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    glShaderSource(shaderID, 1, &source, &size);
+    free(allocated);
+
+    glCompileShader(shaderID);
+
+    GLint logLength;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength) {
+        GLchar *log = (GLchar*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetShaderInfoLog(shaderID, logLength, NULL, log);
+        printf("Shader compile message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    return shaderID;
+}
+
+static GLuint loadShaders(const char *vertex_fn, const char *fragment_fn) {
+    // Compile the shaders
+    GLuint vertexShaderID = loadShader(vertex_fn, GL_VERTEX_SHADER),
+           fragmentShaderID = loadShader(fragment_fn, GL_FRAGMENT_SHADER);
+
+    puts("Linking shader program...");
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    glLinkProgram(programID);
+
+    // Check the program
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0) {
+        char *log = (char*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetProgramInfoLog(programID, logLength, NULL, log);
+        printf("Shader link message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    return programID;
+}
+
+// The ways we know how to smooth edges. They can all be switched between at
+// runtime, since none of them depend on the default framebuffer's format.
+enum AAMode {
+    AA_NONE,     // Aliased; the baseline everything else is compared to
+    AA_MSAA,     // Draw into a 4x multisampled framebuffer, then resolve it
+    AA_FXAA,     // Draw into a single-sampled texture, then blur its edges
+    AA_ANALYTIC, // Compute edge coverage in the fragment shader and blend
+    AA_MODE_COUNT
+};
+
+static const char *const aaModeNames[AA_MODE_COUNT] = {
+    "none", "msaa", "fxaa", "analytic"
+};
+
+// Timings and memory for one AA mode, accumulated for as long as it's active.
+struct ModeStats {
+    unsigned frames;
+    double cpuSeconds;
+    unsigned gpuFrames;
+    double gpuSeconds;
+    size_t targetBytes;
+};
+
+// One vertex of the 2D scene. Lines and polygon outlines are built from quads
+// that the vertex shader widens in screen space, so that edges can fade out
+// over a whole number of pixels whatever the zoom.
+struct Vertex {
+    GLfloat position[2];
+    GLfloat normal[2];
+    GLfloat side;
+    GLfloat halfWidth;
+    GLfloat inset;
+    GLfloat colour[3];
+};
+
+// A polygon is drawn as if its outline were the outer edge of a 1px-wide line
+// running half a pixel inside it. The interior sits on that line's centre, so
+// the coverage shader always sees it as fully covered, and the fringe is the
+// line's outer half, so coverage is 0.5 right on the outline.
+static const GLfloat outlineHalfWidth = 0.5f;
+
+// The scene is laid out in pixels of a window this size.
+static const int sceneWidth = 1024, sceneHeight = 768;
+
+// Number of frames each timer query waits before we read it back, so reading
+// it never stalls the pipeline.
+static const int queryLatency = 4;
+
+static struct {
+    AAMode mode;
+    ModeStats stats[AA_MODE_COUNT];
+
+    GLuint sceneVAOID, emptyVAOID;
+    GLsizei sceneVertexCount;
+    GLuint solidProgramID, coverageProgramID, fxaaProgramID;
+
+    // Offscreen render targets for the current mode, and the size they were
+    // made for
+    int width, height;
+    GLuint framebufferID, colourTextureID, colourRenderbufferID;
+    GLint samples;
+
+    GLuint queryIDs[queryLatency];
+    AAMode queryModes[queryLatency];
+    bool queryPending[queryLatency];
+} aa;
+
+static void addVertex(std::vector<Vertex> &vertices, glm::vec2 position,
+                      glm::vec2 normal, GLfloat side, GLfloat halfWidth,
+                      GLfloat inset, glm::vec3 colour) {
+    vertices.push_back({
+        {position.x, position.y},
+        {normal.x, normal.y},
+        side, halfWidth, inset,
+        {colour.x, colour.y, colour.z}
+    });
+}
+
+static void addLine(std::vector<Vertex> &vertices, glm::vec2 a, glm::vec2 b,
+                    GLfloat width, glm::vec3 colour) {
+    glm::vec2 dir = glm::normalize(b - a),
+              normal = glm::vec2(-dir.y, dir.x);
+    GLfloat halfWidth = width / 2;
+    // Two triangles, with the line's centre running down the diagonal
+    addVertex(vertices, a, normal, -1, halfWidth, 0, colour);
+    addVertex(vertices, b, normal, -1, halfWidth, 0, colour);
+    addVertex(vertices, b, normal,  1, halfWidth, 0, colour);
+    addVertex(vertices, a, normal, -1, halfWidth, 0, colour);
+    addVertex(vertices, b, normal,  1, halfWidth, 0, colour);
+    addVertex(vertices, a, normal,  1, halfWidth, 0, colour);
+}
+
+// Add a polygon given as counter-clockwise points that are all visible from
+// its centre. The interior is a triangle fan, inset half a pixel; around it
+// goes a fringe of quads that covers that last half pixel, and in analytic
+// mode fades out over the pixel either side of the outline.
+static void addPolygon(std::vector<Vertex> &vertices,
+                       const std::vector<glm::vec2> &points,
+                       glm::vec3 colour) {
+    size_t n = points.size();
+    glm::vec2 centre(0);
+    for (glm::vec2 p: points)
+        centre += p;
+    centre /= (float)n;
+
+    // Outward normal of the edge from each point to the next
+    std::vector<glm::vec2> edgeNormals(n);
+    for (size_t i = 0; i < n; i++) {
+        glm::vec2 dir = glm::normalize(points[(i+1) % n] - points[i]);
+        edgeNormals[i] = glm::vec2(dir.y, -dir.x);
+    }
+    // Miter at each point, so that neighbouring fringe quads meet. Sharp
+    // corners are clamped rather than letting the miter run off to infinity.
+    std::vector<glm::vec2> miters(n);
+    for (size_t i = 0; i < n; i++) {
+        const glm::vec2 &before = edgeNormals[(i+n-1) % n],
+                        &after = edgeNormals[i];
+        glm::vec2 miter = glm::normalize(before + after);
+        miters[i] = miter / fmaxf(glm::dot(miter, after), 0.25f);
+    }
+
+    const GLfloat w = outlineHalfWidth;
+    for (size_t i = 0; i < n; i++) {
+        size_t j = (i+1) % n;
+        addVertex(vertices, centre, glm::vec2(0), 0, w, 0, colour);
+        addVertex(vertices, points[i], miters[i], 0, w, w, colour);
+        addVertex(vertices, points[j], miters[j], 0, w, w, colour);
+    }
+    for (size_t i = 0; i < n; i++) {
+        size_t j = (i+1) % n;
+        addVertex(vertices, points[i], miters[i], 0, w, w, colour);
+        addVertex(vertices, points[j], miters[j], 0, w, w, colour);
+        addVertex(vertices, points[j], miters[j], 1, w, w, colour);
+        addVertex(vertices, points[i], miters[i], 0, w, w, colour);
+        addVertex(vertices, points[j], miters[j], 1, w, w, colour);
+        addVertex(vertices, points[i], miters[i], 1, w, w, colour);
+    }
+}
+
+static std::vector<Vertex> sceneVertices() {
+    std::vector<Vertex> vertices;
+    const float pi = 3.14159265f;
+
+    // A five-pointed star: lots of long, nearly-but-not-quite straight edges
+    std::vector<glm::vec2> star;
+    for (int i = 0; i < 10; i++) {
+        float angle = pi/2 + i*pi/5,
+              radius = i % 2 ? 100 : 250;
+        star.push_back(glm::vec2(280 + radius*cosf(angle),
+                                 420 + radius*sinf(angle)));
+    }
+    addPolygon(vertices, star, glm::vec3(1.0f, 0.6f, 0.1f));
+
+    // A thin triangle, slightly off horizontal
+    addPolygon(vertices, {
+        glm::vec2(560, 620), glm::vec2(1000, 660), glm::vec2(600, 700)
+    }, glm::vec3(0.3f, 0.9f, 0.4f));
+
+    // Spokes of hairlines, the classic aliasing test
+    for (int i = 0; i < 48; i++) {
+        float angle = i*pi/24;
+        glm::vec2 dir(cosf(angle), sinf(angle));
+        addLine(vertices, glm::vec2(770, 320) + 20.f*dir,
+                glm::vec2(770, 320) + 220.f*dir, 1, glm::vec3(1));
+    }
+
+    // A thicker sine wave along the bottom
+    glm::vec2 previous(20, 90);
+    for (int x = 30; x <= 1000; x += 10) {
+        glm::vec2 next(x, 90 + 50*sinf(x / 60.f));
+        addLine(vertices, previous, next, 3, glm::vec3(0.4f, 0.7f, 1.0f));
+        previous = next;
+    }
+
+    return vertices;
+}
+
+static void sceneAttribs(const std::vector<Vertex> &vertices) {
+    GLuint vboID;
+    glGenBuffers(1, &vboID);
+    glBindBuffer(GL_ARRAY_BUFFER, vboID);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex),
+        vertices.data(), GL_STATIC_DRAW);
+
+    // All attributes are interleaved in the one buffer. The attribute IDs must
+    // match the layout in edge-vertex.glsl.
+    const GLsizei stride = sizeof(Vertex);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, stride,
+        (const void*)offsetof(Vertex, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, stride,
+        (const void*)offsetof(Vertex, normal));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride,
+        (const void*)offsetof(Vertex, side));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, stride,
+        (const void*)offsetof(Vertex, halfWidth));
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 1, GL_FLOAT, GL_FALSE, stride,
+        (const void*)offsetof(Vertex, inset));
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, stride,
+        (const void*)offsetof(Vertex, colour));
+}
+
+static void deleteTargets() {
+    if (aa.framebufferID)
+        glDeleteFramebuffers(1, &aa.framebufferID);
+    if (aa.colourTextureID)
+        glDeleteTextures(1, &aa.colourTextureID);
+    if (aa.colourRenderbufferID)
+        glDeleteRenderbuffers(1, &aa.colourRenderbufferID);
+    aa.framebufferID = aa.colourTextureID = aa.colourRenderbufferID = 0;
+}
+
+// (Re)make the offscreen render targets the current mode needs, and return how
+// many bytes they take up. Only one mode's targets exist at a time, so the
+// memory reported for a mode is what a deployment using it would pay.
+static size_t makeTargets(int width, int height) {
+    deleteTargets();
+    aa.width = width;
+    aa.height = height;
+
+    // Edges are widened in real pixels, which on a HiDPI screen or after a
+    // resize aren't the scene's units
+    for (GLuint programID: {aa.solidProgramID, aa.coverageProgramID}) {
+        glUseProgram(programID);
+        glUniform2f(glGetUniformLocation(programID, "viewport"),
+            width, height);
+    }
+
+    size_t bytes = 0;
+    const size_t pixelBytes = 4; // GL_RGBA8
+    switch (aa.mode) {
+    case AA_MSAA:
+        glGenRenderbuffers(1, &aa.colourRenderbufferID);
+        glBindRenderbuffer(GL_RENDERBUFFER, aa.colourRenderbufferID);
+        glRenderbufferStorageMultisample(GL_RENDERBUFFER, aa.samples, GL_RGBA8,
+            width, height);
+        glGenFramebuffers(1, &aa.framebufferID);
+        glBindFramebuffer(GL_FRAMEBUFFER, aa.framebufferID);
+        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_RENDERBUFFER, aa.colourRenderbufferID);
+        bytes = (size_t)width * height * pixelBytes * aa.samples;
+        break;
+    case AA_FXAA:
+        glGenTextures(1, &aa.colourTextureID);
+        glBindTexture(GL_TEXTURE_2D, aa.colourTextureID);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA,
+            GL_UNSIGNED_BYTE, NULL);
+        // FXAA relies on bilinear filtering to blend between its taps
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glGenFramebuffers(1, &aa.framebufferID);
+        glBindFramebuffer(GL_FRAMEBUFFER, aa.framebufferID);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D, aa.colourTextureID, 0);
+        bytes = (size_t)width * height * pixelBytes;
+        break;
+    default:
+        // Draw straight to the window
+        return 0;
+    }
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        fprintf(stderr, "Failed to make %s framebuffer\n",
+            aaModeNames[aa.mode]);
+        exit(1);
+    }
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    return bytes;
+}
+
+static void setMode(AAMode mode, GLFWwindow *window) {
+    aa.mode = mode;
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    aa.stats[mode].targetBytes = makeTargets(width, height);
+    printf("AA mode: %s (%.1f MiB of extra render targets)\n",
+        aaModeNames[mode], aa.stats[mode].targetBytes / 1048576.0);
+
+    bool analytic = mode == AA_ANALYTIC;
+    // Coverage is written to alpha, and needs blending to take effect
+    if (analytic) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    } else
+        glDisable(GL_BLEND);
+}
+
+static void keyCallback(GLFWwindow *window, int key, int scancode,
+                        int action, int mods) {
+    if (action == GLFW_PRESS && key >= GLFW_KEY_1 &&
+        key < GLFW_KEY_1 + AA_MODE_COUNT)
+        setMode((AAMode)(key - GLFW_KEY_1), window);
+}
+
+static GLuint edgeProgram(const char *fragment_fn, GLfloat fringe) {
+    GLuint programID = loadShaders("edge-vertex.glsl", fragment_fn);
+    glUseProgram(programID);
+    glUniform2f(glGetUniformLocation(programID, "scene"),
+        sceneWidth, sceneHeight);
+    glUniform1f(glGetUniformLocation(programID, "fringe"), fringe);
+    return programID;
+}
+
+static void init(GLFWwindow **window, AAMode mode) {
+    // Set error callback to see more detailed failure info
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    // No multisampling on the window itself: it would be paid for in every
+    // mode. MSAA mode draws into its own multisampled framebuffer instead.
+    glfwWindowHint(GLFW_SAMPLES, 0);
+
+    // To ensure compatiblity, check the output of this command:
+    // $ glxinfo | grep 'Max core profile version'
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+    // To make MacOS happy
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // We don't want the old OpenGL
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Open a window and create its OpenGL context
+    *window = glfwCreateWindow(sceneWidth, sceneHeight,
+        "Tutorial 05 - Anti-aliasing modes", NULL, NULL);
+    if (!*window) {
+        fputs("Failed to open GLFW window.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(*window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(*window, GLFW_STICKY_KEYS, GL_TRUE);
+    // Keys 1-4 switch AA mode
+    glfwSetKeyCallback(*window, keyCallback);
+    // Don't wait for vsync, or every mode would take the same time per frame
+    glfwSwapInterval(0);
+
+    // Dark blue background
+    glClearColor(0.0, 0.0, 0.4, 0.0);
+
+    // The fullscreen pass has no vertex attributes, but core profile still
+    // wants a VAO bound to draw.
+    glGenVertexArrays(1, &aa.emptyVAOID);
+
+    // Make the VAO.
+    glGenVertexArrays(1, &aa.sceneVAOID);
+    glBindVertexArray(aa.sceneVAOID);
+    std::vector<Vertex> vertices = sceneVertices();
+    sceneAttribs(vertices);
+    aa.sceneVertexCount = vertices.size();
+    // The VAO is ready.
+
+    // Create and compile our GLSL programs from the shaders
+    aa.solidProgramID = edgeProgram("solid-fragment.glsl", 0);
+    aa.coverageProgramID = edgeProgram("coverage-fragment.glsl", 1);
+    aa.fxaaProgramID = loadShaders(
+        "fullscreen-vertex.glsl", "fxaa-fragment.glsl");
+    glUseProgram(aa.fxaaProgramID);
+    glUniform1i(glGetUniformLocation(aa.fxaaProgramID, "scene"), 0);
+
+    GLint maxSamples;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    aa.samples = maxSamples < 4 ? maxSamples : 4; // 4x antialiasing
+
+    glGenQueries(queryLatency, aa.queryIDs);
+    setMode(mode, *window);
+
+    puts("Initialized.");
+}
+
+static void drawFrame(GLFWwindow *window) {
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    if (width != aa.width || height != aa.height)
+        aa.stats[aa.mode].targetBytes = makeTargets(width, height);
+
+    glBindFramebuffer(GL_FRAMEBUFFER, aa.framebufferID);
+    glViewport(0, 0, width, height);
+
+    // Clear the screen
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glBindVertexArray(aa.sceneVAOID);
+    glUseProgram(aa.mode == AA_ANALYTIC ?
+        aa.coverageProgramID : aa.solidProgramID);
+    glDrawArrays(GL_TRIANGLES, 0, aa.sceneVertexCount);
+
+    switch (aa.mode) {
+    case AA_MSAA:
+        // Resolve the samples into the window
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, aa.framebufferID);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height,
+            GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        break;
+    case AA_FXAA:
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glUseProgram(aa.fxaaProgramID);
+        glUniform2f(glGetUniformLocation(aa.fxaaProgramID, "texelSize"),
+            1.f/width, 1.f/height);
+        glActiveTexture(GL_TEXTURE0);
+        glBindTexture(GL_TEXTURE_2D, aa.colourTextureID);
+        glBindVertexArray(aa.emptyVAOID);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        break;
+    default:
+        break;
+    }
+}
+
+// Collect the GPU time of the frame drawn queryLatency frames ago, and start
+// timing this one in its place.
+static void beginGPUTimer(unsigned frame) {
+    int slot = frame % queryLatency;
+    if (aa.queryPending[slot]) {
+        GLuint64 nanoseconds;
+        glGetQueryObjectui64v(aa.queryIDs[slot], GL_QUERY_RESULT,
+            &nanoseconds);
+        ModeStats &stats = aa.stats[aa.queryModes[slot]];
+        stats.gpuFrames++;
+        stats.gpuSeconds += nanoseconds * 1e-9;
+    }
+    aa.queryModes[slot] = aa.mode;
+    aa.queryPending[slot] = true;
+    glBeginQuery(GL_TIME_ELAPSED, aa.queryIDs[slot]);
+}
+
+static void printStats() {
+    puts("mode      frames  cpu ms/frame  gpu ms/frame  extra MiB");
+    for (int m = 0; m < AA_MODE_COUNT; m++) {
+        const ModeStats &stats = aa.stats[m];
+        if (!stats.frames)
+            continue;
+        printf("%-8s  %6u  %12.3f  %12.3f  %9.1f\n", aaModeNames[m],
+            stats.frames, 1e3 * stats.cpuSeconds / stats.frames,
+            stats.gpuFrames ? 1e3 * stats.gpuSeconds / stats.gpuFrames : 0,
+            stats.targetBytes / 1048576.0);
+    }
+}
+
+static void usage() {
+    fputs("Usage: 05 [none|msaa|fxaa|analytic|bench]\n"
+          "  bench draws a fixed number of frames in each mode, then exits.\n"
+          "  Otherwise, keys 1-4 switch mode while running.\n", stderr);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    markMainStart();
+
+    AAMode mode = AA_ANALYTIC;
+    bool bench = false;
+    if (argc > 2)
+        usage();
+    if (argc == 2) {
+        bench = !strcmp(argv[1], "bench");
+        if (bench)
+            mode = AA_NONE;
+        else {
+            int m = 0;
+            while (m < AA_MODE_COUNT && strcmp(argv[1], aaModeNames[m]))
+                m++;
+            if (m == AA_MODE_COUNT)
+                usage();
+            mode = (AAMode)m;
+        }
+    }
+
+    GLFWwindow *window;
+    init(&window, mode);
+
+    // In bench mode, skip a few frames after each switch so that the
+    // driver's first-use costs aren't counted.
+    const unsigned benchFrames = 500, warmupFrames = 20;
+    unsigned frame = 0, modeFrame = 0;
+    AAMode lastMode = aa.mode;
+    double lastTime = glfwGetTime();
+
+    do {
+        beginGPUTimer(frame);
+        drawFrame(window);
+        glEndQuery(GL_TIME_ELAPSED);
+
+        // Swap buffers
+        glfwSwapBuffers(window);
+        reportStartupTime();
+        glfwPollEvents();
+
+        double now = glfwGetTime();
+        if (aa.mode != lastMode) {
+            lastMode = aa.mode;
+            modeFrame = 0;
+        } else if (!bench || modeFrame >= warmupFrames) {
+            aa.stats[aa.mode].frames++;
+            aa.stats[aa.mode].cpuSeconds += now - lastTime;
+        }
+        lastTime = now;
+        frame++;
+        modeFrame++;
+
+        if (bench && modeFrame == warmupFrames + benchFrames) {
+            if (aa.mode + 1 == AA_MODE_COUNT)
+                break;
+            setMode((AAMode)(aa.mode + 1), window);
+        }
+
+        // Check if the ESC key was pressed or the window was closed
+    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+             !glfwWindowShouldClose(window));
+
+    printStats();
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec3 fragmentColor;
+in float edgeDistance;
+in float halfWidth;
+
+// Output data
+out vec4 color;
+
+void main() {
+    // Approximate the fraction of this pixel covered by the shape from its
+    // distance (in pixels) to the centre of the line it's on: fully covered
+    // half a pixel inside the line's edge, not covered at all half a pixel
+    // outside, and half covered on it. A polygon's outline is such an edge.
+    float coverage = clamp(halfWidth + 0.5 - abs(edgeDistance), 0, 1);
+    color = vec4(fragmentColor, coverage);
+}
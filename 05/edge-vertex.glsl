@@ -0,0 +1,41 @@
+#version 330 core
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec2 vertexPosition_scenespace;
+// Direction to push this vertex out from the edge it belongs to. Zero for
+// polygon interiors, scaled by the miter length at polygon corners.
+layout(location = 1) in vec2 vertexNormal;
+// Which side of the line's centre this vertex sits on: -1 or 1 across a line,
+// 0 (on the centre) or 1 (outside) across a polygon outline.
+layout(location = 2) in float vertexSide;
+// Half of the line width in pixels.
+layout(location = 3) in float vertexHalfWidth;
+// How far inside the given position the line's centre runs, in pixels. 0 for
+// a line; a polygon's outline is the outer edge of a line inside it.
+layout(location = 4) in float vertexInset;
+layout(location = 5) in vec3 vertexColor;
+
+// Output data; will be interpolated for each fragment.
+out vec3 fragmentColor;
+out float edgeDistance;
+out float halfWidth;
+
+// Size of the framebuffer in pixels, and of the scene in its own units.
+uniform vec2 viewport;
+uniform vec2 scene;
+// Extra pixels of geometry around every edge. The coverage fragment shader
+// fades out over this band; it's 0 when another AA mode does the smoothing.
+uniform float fringe;
+
+void main() {
+    // Normals are taken to be in pixels as they are, which is exact as long
+    // as the window keeps the scene's aspect ratio.
+    float distance = vertexSide * (vertexHalfWidth + fringe);
+    vec2 position = vertexPosition_scenespace * viewport / scene
+                  + vertexNormal * (distance - vertexInset);
+    gl_Position = vec4(position / viewport * 2 - 1, 0, 1);
+
+    edgeDistance = distance;
+    halfWidth = vertexHalfWidth;
+    fragmentColor = vertexColor;
+}
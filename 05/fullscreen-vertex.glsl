@@ -0,0 +1,11 @@
+#version 330 core
+
+// Output data; will be interpolated for each fragment.
+out vec2 uv;
+
+void main() {
+    // One triangle that covers the whole screen, generated from the vertex
+    // index so no vertex buffer is needed: (0,0), (2,0), (0,2).
+    uv = vec2((gl_VertexID << 1) & 2, gl_VertexID & 2);
+    gl_Position = vec4(uv * 2 - 1, 0, 1);
+}
@@ -0,0 +1,52 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec2 uv;
+
+// Output data
+out vec4 color;
+
+// The single-sampled scene, and the size of one of its texels in uv units.
+uniform sampler2D scene;
+uniform vec2 texelSize;
+
+// Tuning constants from the original FXAA: ignore very dark edges, and never
+// blur along an edge further than this many texels.
+#define FXAA_REDUCE_MIN (1.0 / 128.0)
+#define FXAA_REDUCE_MUL (1.0 / 8.0)
+#define FXAA_SPAN_MAX   8.0
+
+void main() {
+    vec3 rgbNW = texture(scene, uv + vec2(-1, -1) * texelSize).rgb;
+    vec3 rgbNE = texture(scene, uv + vec2( 1, -1) * texelSize).rgb;
+    vec3 rgbSW = texture(scene, uv + vec2(-1,  1) * texelSize).rgb;
+    vec3 rgbSE = texture(scene, uv + vec2( 1,  1) * texelSize).rgb;
+    vec3 rgbM  = texture(scene, uv).rgb;
+
+    vec3 toLuma = vec3(0.299, 0.587, 0.114);
+    float lumaNW = dot(rgbNW, toLuma);
+    float lumaNE = dot(rgbNE, toLuma);
+    float lumaSW = dot(rgbSW, toLuma);
+    float lumaSE = dot(rgbSE, toLuma);
+    float lumaM  = dot(rgbM,  toLuma);
+    float lumaMin = min(lumaM, min(min(lumaNW, lumaNE), min(lumaSW, lumaSE)));
+    float lumaMax = max(lumaM, max(max(lumaNW, lumaNE), max(lumaSW, lumaSE)));
+
+    // The edge runs perpendicular to the luma gradient
+    vec2 dir = vec2(-((lumaNW + lumaNE) - (lumaSW + lumaSE)),
+                      (lumaNW + lumaSW) - (lumaNE + lumaSE));
+    float dirReduce = max((lumaNW + lumaNE + lumaSW + lumaSE)
+                          * (0.25 * FXAA_REDUCE_MUL), FXAA_REDUCE_MIN);
+    float rcpDirMin = 1 / (min(abs(dir.x), abs(dir.y)) + dirReduce);
+    dir = clamp(dir * rcpDirMin, vec2(-FXAA_SPAN_MAX), vec2(FXAA_SPAN_MAX))
+        * texelSize;
+
+    // Blend along the edge, falling back to the narrower blend if the wider
+    // one picked up colours from outside the local contrast range.
+    vec3 rgbA = 0.5 * (texture(scene, uv + dir * (1.0 / 3 - 0.5)).rgb +
+                       texture(scene, uv + dir * (2.0 / 3 - 0.5)).rgb);
+    vec3 rgbB = rgbA * 0.5 + 0.25 * (texture(scene, uv - dir * 0.5).rgb +
+                                     texture(scene, uv + dir * 0.5).rgb);
+    float lumaB = dot(rgbB, toLuma);
+    color = vec4((lumaB < lumaMin || lumaB > lumaMax) ? rgbA : rgbB, 1);
+}
@@ -0,0 +1,13 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec3 fragmentColor;
+
+// Output data
+out vec4 color;
+
+void main() {
+    // Every covered pixel gets the full colour; smoothing, if any, is done by
+    // multisampling or by the FXAA pass afterwards.
+    color = vec4(fragmentColor, 1);
+}
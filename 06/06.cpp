@@ -0,0 +1,649 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../common/gltrace.h"
+#include "../common/startup-time.h"
+#include "shaders.h"
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+static GLuint loadShader(const char *fn, GLenum shaderType) {
+    printf("Compiling shader '%s'...\n", fn);
+
+    GLuint shaderID = glCreateShader(shaderType);
+    if (!shaderID) {
+        fprintf(stderr, "Failed to create shader\n");
+        exit(1);
+    }
+
+    // Embedded at build time, unless SHADER_DIR says to read it from disk
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    glShaderSource(shaderID, 1, &source, &size);
+    free(allocated);
+
+    glCompileShader(shaderID);
+
+    GLint logLength;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength) {
+        GLchar *log = (GLchar*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetShaderInfoLog(shaderID, logLength, NULL, log);
+        printf("Shader compile message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    return shaderID;
+}
+
+static GLuint loadShaders(const char *vertex_fn, const char *fragment_fn) {
+    // Compile the shaders
+    GLuint vertexShaderID = loadShader(vertex_fn, GL_VERTEX_SHADER),
+           fragmentShaderID = loadShader(fragment_fn, GL_FRAGMENT_SHADER);
+
+    puts("Linking shader program...");
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    glLinkProgram(programID);
+
+    // Check the program
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0) {
+        char *log = (char*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetProgramInfoLog(programID, logLength, NULL, log);
+        printf("Shader link message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    return programID;
+}
+
+static void vertexAttribs() {
+    // Our vertices. Three consecutive floats give a 3D vertex; Three
+    // consecutive vertices give a triangle.
+    // A cube has 6 faces with 2 triangles each, so this makes 6*2=12 triangles,
+    // and 12*3 vertices
+    static const GLfloat vertexData[] = {
+        -1.0f,-1.0f,-1.0f,
+        -1.0f,-1.0f, 1.0f,
+        -1.0f, 1.0f, 1.0f,
+         1.0f, 1.0f,-1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f, 1.0f,
+        -1.0f,-1.0f,-1.0f,
+         1.0f,-1.0f,-1.0f,
+         1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f,-1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f, 1.0f,
+        -1.0f,-1.0f, 1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f, 1.0f, 1.0f,
+        -1.0f,-1.0f, 1.0f,
+         1.0f,-1.0f, 1.0f,
+         1.0f, 1.0f, 1.0f,
+         1.0f,-1.0f,-1.0f,
+         1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f,-1.0f,
+         1.0f, 1.0f, 1.0f,
+         1.0f,-1.0f, 1.0f,
+         1.0f, 1.0f, 1.0f,
+         1.0f, 1.0f,-1.0f,
+        -1.0f, 1.0f,-1.0f,
+         1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f,-1.0f,
+        -1.0f, 1.0f, 1.0f,
+         1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f, 1.0f,
+         1.0f,-1.0f, 1.0f
+    };
+    // Make the VBO and add it to the VAO.
+    GLuint vertexVBOID;
+    glGenBuffers(1, &vertexVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexVBOID);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData,
+        GL_STATIC_DRAW);
+    // 1st attribute buffer: vertices
+    const GLuint vertexVAAID = 0;
+    glEnableVertexAttribArray(vertexVAAID);
+    glVertexAttribPointer(
+        vertexVAAID,  // attribute. No particular reason for 0, but must match
+                      // the layout in the shader.
+        3,            // size
+        GL_FLOAT,     // type
+        GL_FALSE,     // normalized?
+        0,            // stride
+        NULL          // array buffer offset
+    );
+}
+
+static void colourAttribs() {
+    // One color for each vertex. They were generated randomly.
+    static const GLfloat colourData[] = {
+        0.583f,  0.771f,  0.014f,
+        0.609f,  0.115f,  0.436f,
+        0.327f,  0.483f,  0.844f,
+        0.822f,  0.569f,  0.201f,
+        0.435f,  0.602f,  0.223f,
+        0.310f,  0.747f,  0.185f,
+        0.597f,  0.770f,  0.761f,
+        0.559f,  0.436f,  0.730f,
+        0.359f,  0.583f,  0.152f,
+        0.483f,  0.596f,  0.789f,
+        0.559f,  0.861f,  0.639f,
+        0.195f,  0.548f,  0.859f,
+        0.014f,  0.184f,  0.576f,
+        0.771f,  0.328f,  0.970f,
+        0.406f,  0.615f,  0.116f,
+        0.676f,  0.977f,  0.133f,
+        0.971f,  0.572f,  0.833f,
+        0.140f,  0.616f,  0.489f,
+        0.997f,  0.513f,  0.064f,
+        0.945f,  0.719f,  0.592f,
+        0.543f,  0.021f,  0.978f,
+        0.279f,  0.317f,  0.505f,
+        0.167f,  0.620f,  0.077f,
+        0.347f,  0.857f,  0.137f,
+        0.055f,  0.953f,  0.042f,
+        0.714f,  0.505f,  0.345f,
+        0.783f,  0.290f,  0.734f,
+        0.722f,  0.645f,  0.174f,
+        0.302f,  0.455f,  0.848f,
+        0.225f,  0.587f,  0.040f,
+        0.517f,  0.713f,  0.338f,
+        0.053f,  0.959f,  0.120f,
+        0.393f,  0.621f,  0.362f,
+        0.673f,  0.211f,  0.457f,
+        0.820f,  0.883f,  0.371f,
+        0.982f,  0.099f,  0.879f
+    };
+    GLuint colourVBOID;
+    glGenBuffers(1, &colourVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, colourVBOID);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(colourData), colourData,
+        GL_STATIC_DRAW);
+    // 2nd attribute buffer: colors
+    const GLuint colourVAAID = 1;
+    glEnableVertexAttribArray(colourVAAID);
+    glVertexAttribPointer(
+        colourVAAID,  // attribute. No particular reason for 1, but must match
+                      // the layout in the shader.
+        3,            // size
+        GL_FLOAT,     // type
+        GL_FALSE,     // normalized?
+        0,            // stride
+        NULL          // array buffer offset
+    );
+}
+
+// The order in which cubes are submitted each frame
+enum SortMode {
+    SORT_NONE,          // Shuffled once at startup, like any unsorted scene
+    SORT_FRONT_TO_BACK, // Nearest first, so later fragments fail the depth test
+    SORT_BACK_TO_FRONT, // Farthest first: the worst case, for comparison
+    SORT_MODE_COUNT
+};
+
+static const char *const sortModeNames[SORT_MODE_COUNT] = {
+    "unsorted", "front-to-back", "back-to-front"
+};
+
+// Every combination of sort mode and depth pre-pass gets its own stats.
+static const int configCount = 2 * SORT_MODE_COUNT;
+
+struct ConfigStats {
+    unsigned frames;
+    double cpuSeconds, sortSeconds;
+    unsigned gpuFrames;
+    double gpuSeconds;
+    // Fragments that passed the depth test in the shading pass, i.e. the ones
+    // that ran the expensive fragment shader
+    GLuint64 shadedFragments;
+};
+
+// A cube of cubes, gridSize on a side
+static const int gridSize = 20,
+                 instanceCount = gridSize * gridSize * gridSize;
+static const float gridSpacing = 2, cubeScale = 0.5f;
+
+static const float nearPlane = 0.1f, farPlane = 200;
+
+// Number of frames each query waits before we read it back, so reading it
+// never stalls the pipeline.
+static const int queryLatency = 4;
+
+static struct {
+    bool prePass, overdraw;
+    SortMode sort;
+    ConfigStats stats[configCount];
+
+    GLuint instanceVBOID;
+    // Cube positions in submission order when unsorted, and the buffers the
+    // sort works in
+    std::vector<glm::vec3> offsets, sortedOffsets;
+    std::vector<uint16_t> depthKeys;
+    std::vector<uint32_t> order, scratch;
+    bool instancesDirty;
+
+    GLuint depthProgramID, heavyProgramID, overdrawProgramID;
+
+    GLuint timerQueryIDs[queryLatency], sampleQueryIDs[queryLatency];
+    int queryConfigs[queryLatency];
+    bool queryPending[queryLatency];
+} scene;
+
+static int currentConfig() {
+    return scene.prePass * SORT_MODE_COUNT + scene.sort;
+}
+
+static void printConfig() {
+    printf("%s, %s%s\n", sortModeNames[scene.sort],
+        scene.prePass ? "depth pre-pass" : "no pre-pass",
+        scene.overdraw ? ", showing overdraw" : "");
+}
+
+static void instanceAttribs() {
+    // Lay the cubes out on a grid centred on the origin, then shuffle them so
+    // that the unsorted order doesn't happen to favour any viewpoint.
+    const float half = (gridSize - 1) * gridSpacing / 2;
+    for (int x = 0; x < gridSize; x++)
+        for (int y = 0; y < gridSize; y++)
+            for (int z = 0; z < gridSize; z++)
+                scene.offsets.push_back(
+                    glm::vec3(x, y, z) * gridSpacing - glm::vec3(half));
+    std::shuffle(scene.offsets.begin(), scene.offsets.end(),
+        std::mt19937(4));
+
+    // Everything the per-frame sort needs is allocated up front
+    scene.sortedOffsets.resize(instanceCount);
+    scene.depthKeys.resize(instanceCount);
+    scene.order.resize(instanceCount);
+    scene.scratch.resize(instanceCount);
+
+    glGenBuffers(1, &scene.instanceVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.instanceVBOID);
+    glBufferData(GL_ARRAY_BUFFER, instanceCount * sizeof(glm::vec3),
+        scene.offsets.data(), GL_DYNAMIC_DRAW);
+    // 3rd attribute buffer: cube positions, advancing once per instance
+    // rather than once per vertex
+    const GLuint offsetVAAID = 2;
+    glEnableVertexAttribArray(offsetVAAID);
+    glVertexAttribPointer(offsetVAAID, 3, GL_FLOAT, GL_FALSE, 0, NULL);
+    glVertexAttribDivisor(offsetVAAID, 1);
+}
+
+// Sort indices by their 16-bit keys, smallest first. This is a least
+// significant digit radix sort: two stable counting passes of 8 bits each,
+// so it's linear in the number of instances and never compares anything.
+// The result ends up back in order; scratch must be just as big.
+static void radixSort(const uint16_t *keys, uint32_t *order, uint32_t *scratch,
+                      size_t n) {
+    for (int shift = 0; shift < 16; shift += 8) {
+        size_t starts[257] = {0};
+        for (size_t i = 0; i < n; i++)
+            starts[((keys[order[i]] >> shift) & 0xFF) + 1]++;
+        for (int digit = 0; digit < 256; digit++)
+            starts[digit + 1] += starts[digit];
+        for (size_t i = 0; i < n; i++)
+            scratch[starts[(keys[order[i]] >> shift) & 0xFF]++] = order[i];
+        std::swap(order, scratch);
+    }
+}
+
+// Reorder the instance buffer for this frame's camera, if sorting is on.
+static void sortInstances(const glm::mat4 &view) {
+    if (scene.sort == SORT_NONE) {
+        if (scene.instancesDirty) {
+            glBindBuffer(GL_ARRAY_BUFFER, scene.instanceVBOID);
+            glBufferSubData(GL_ARRAY_BUFFER, 0,
+                instanceCount * sizeof(glm::vec3), scene.offsets.data());
+            scene.instancesDirty = false;
+        }
+        return;
+    }
+
+    // Quantize each cube centre's view depth to 16 bits over the depth range.
+    // Only the z row of the view matrix is needed for that.
+    const glm::vec3 zRow(view[0][2], view[1][2], view[2][2]);
+    const float zOffset = view[3][2],
+                keyScale = 65535 / (farPlane - nearPlane);
+    const bool reverse = scene.sort == SORT_BACK_TO_FRONT;
+    for (int i = 0; i < instanceCount; i++) {
+        float depth = -(glm::dot(zRow, scene.offsets[i]) + zOffset);
+        float key = (depth - nearPlane) * keyScale;
+        key = key < 0 ? 0 : key > 65535 ? 65535 : key;
+        scene.depthKeys[i] = reverse ? 65535 - (uint16_t)key : (uint16_t)key;
+        scene.order[i] = i;
+    }
+    radixSort(scene.depthKeys.data(), scene.order.data(),
+        scene.scratch.data(), instanceCount);
+
+    for (int i = 0; i < instanceCount; i++)
+        scene.sortedOffsets[i] = scene.offsets[scene.order[i]];
+    glBindBuffer(GL_ARRAY_BUFFER, scene.instanceVBOID);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(glm::vec3),
+        scene.sortedOffsets.data());
+    scene.instancesDirty = true;
+}
+
+static void keyCallback(GLFWwindow *window, int key, int scancode,
+                        int action, int mods) {
+    if (action != GLFW_PRESS)
+        return;
+    switch (key) {
+    case GLFW_KEY_P:
+        scene.prePass = !scene.prePass;
+        break;
+    case GLFW_KEY_S:
+        scene.sort = (SortMode)((scene.sort + 1) % SORT_MODE_COUNT);
+        break;
+    case GLFW_KEY_O:
+        scene.overdraw = !scene.overdraw;
+        break;
+    default:
+        return;
+    }
+    printConfig();
+}
+
+static GLuint cubeProgram(const char *fragment_fn) {
+    GLuint programID = loadShaders("instanced-vertex.glsl", fragment_fn);
+    glUseProgram(programID);
+    glUniform1f(glGetUniformLocation(programID, "cubeScale"), cubeScale);
+    return programID;
+}
+
+static void init(GLFWwindow **window) {
+    // Set error callback to see more detailed failure info
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    // No antialiasing, so that samples passed is the same as fragments shaded
+    glfwWindowHint(GLFW_SAMPLES, 0);
+
+    // To ensure compatiblity, check the output of this command:
+    // $ glxinfo | grep 'Max core profile version'
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+    // To make MacOS happy
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // We don't want the old OpenGL
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Open a window and create its OpenGL context
+    *window = glfwCreateWindow(1024, 768,
+        "Tutorial 06 - Overdraw", NULL, NULL);
+    if (!*window) {
+        fputs("Failed to open GLFW window.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(*window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(*window, GLFW_STICKY_KEYS, GL_TRUE);
+    // P toggles the pre-pass, S cycles the sort mode, O toggles overdraw view
+    glfwSetKeyCallback(*window, keyCallback);
+    // Don't wait for vsync, so frame times mean something
+    glfwSwapInterval(0);
+
+    // Dark blue background
+    glClearColor(0.0, 0.0, 0.4, 0.0);
+
+    // Enable depth test
+    glEnable(GL_DEPTH_TEST);
+
+    // Make the VAO.
+    GLuint vaoID;
+    glGenVertexArrays(1, &vaoID);
+    glBindVertexArray(vaoID);
+    vertexAttribs();
+    colourAttribs();
+    instanceAttribs();
+    // The VAO is ready.
+
+    // Create and compile our GLSL programs from the shaders
+    scene.depthProgramID = cubeProgram("depth-fragment.glsl");
+    scene.heavyProgramID = cubeProgram("heavy-fragment.glsl");
+    glUniform1i(glGetUniformLocation(scene.heavyProgramID, "iterations"), 64);
+    scene.overdrawProgramID = cubeProgram("overdraw-fragment.glsl");
+
+    glGenQueries(queryLatency, scene.timerQueryIDs);
+    glGenQueries(queryLatency, scene.sampleQueryIDs);
+
+    puts("Initialized.");
+    printConfig();
+}
+
+static void drawCubes(GLuint programID, const glm::mat4 &vp) {
+    glUseProgram(programID);
+    glUniformMatrix4fv(glGetUniformLocation(programID, "VP"), 1, GL_FALSE,
+        &vp[0][0]);
+    // 12*3 vertices per cube, once for every cube
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 12*3, instanceCount);
+}
+
+// Draw one frame, and return how long sorting the cubes took.
+static double drawFrame(float angle, int slot) {
+    // Orbit the camera around the grid
+    const float radius = gridSize * gridSpacing * 1.2f;
+    glm::mat4 projection = glm::perspective(
+        glm::radians(45.f), 4.f/3, nearPlane, farPlane);
+    glm::mat4 view = glm::lookAt(
+        glm::vec3(radius*cosf(angle), radius*0.6f, radius*sinf(angle)),
+        glm::vec3(0, 0, 0),
+        glm::vec3(0, 1, 0)
+    );
+    glm::mat4 vp = projection * view;
+
+    double sortStart = glfwGetTime();
+    sortInstances(view);
+    double sortSeconds = glfwGetTime() - sortStart;
+
+    // Clear the screen. Depth writes must be on for this to clear depth.
+    glDepthMask(GL_TRUE);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    if (scene.prePass) {
+        // Lay down the nearest depth at every pixel without shading anything,
+        // then shade only the fragments that match it exactly.
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        glDepthFunc(GL_LESS);
+        drawCubes(scene.depthProgramID, vp);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_EQUAL);
+    } else {
+        // Accept fragment if it's closer to the camera than the former one
+        glDepthFunc(GL_LESS);
+    }
+
+    glBeginQuery(GL_SAMPLES_PASSED, scene.sampleQueryIDs[slot]);
+    if (scene.overdraw) {
+        // Count shaded fragments per pixel instead of shading them
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+        drawCubes(scene.overdrawProgramID, vp);
+        glDisable(GL_BLEND);
+    } else
+        drawCubes(scene.heavyProgramID, vp);
+    glEndQuery(GL_SAMPLES_PASSED);
+
+    return sortSeconds;
+}
+
+// Collect the queries of the frame drawn queryLatency frames ago, and start
+// timing this one in its place.
+static int beginQueries(unsigned frame) {
+    int slot = frame % queryLatency;
+    if (scene.queryPending[slot]) {
+        GLuint64 nanoseconds, samples;
+        glGetQueryObjectui64v(scene.timerQueryIDs[slot], GL_QUERY_RESULT,
+            &nanoseconds);
+        glGetQueryObjectui64v(scene.sampleQueryIDs[slot], GL_QUERY_RESULT,
+            &samples);
+        ConfigStats &stats = scene.stats[scene.queryConfigs[slot]];
+        stats.gpuFrames++;
+        stats.gpuSeconds += nanoseconds * 1e-9;
+        stats.shadedFragments += samples;
+    }
+    // Overdraw view costs something different, so isn't counted
+    scene.queryPending[slot] = !scene.overdraw;
+    scene.queryConfigs[slot] = currentConfig();
+    glBeginQuery(GL_TIME_ELAPSED, scene.timerQueryIDs[slot]);
+    return slot;
+}
+
+static void printStats(GLFWwindow *window) {
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    const double pixels = (double)width * height;
+
+    puts("order          pre-pass  frames  cpu ms  sort ms  gpu ms  "
+         "shaded/pixel");
+    for (int c = 0; c < configCount; c++) {
+        const ConfigStats &stats = scene.stats[c];
+        if (!stats.frames)
+            continue;
+        unsigned gpuFrames = stats.gpuFrames ? stats.gpuFrames : 1;
+        printf("%-13s  %-8s  %6u  %6.2f  %7.2f  %6.2f  %12.2f\n",
+            sortModeNames[c % SORT_MODE_COUNT],
+            c / SORT_MODE_COUNT ? "yes" : "no", stats.frames,
+            1e3 * stats.cpuSeconds / stats.frames,
+            1e3 * stats.sortSeconds / stats.frames,
+            1e3 * stats.gpuSeconds / gpuFrames,
+            stats.shadedFragments / (pixels * gpuFrames));
+    }
+}
+
+int main(int argc, char **argv) {
+    markMainStart();
+
+    bool bench = argc == 2 && !strcmp(argv[1], "bench");
+    if (argc > 1 && !bench) {
+        fputs("Usage: 06 [bench]\n"
+              "  bench draws a fixed number of frames in every combination of\n"
+              "  sort order and pre-pass, then exits.\n"
+              "  Otherwise, P toggles the depth pre-pass, S cycles the sort\n"
+              "  order and O toggles the overdraw view while running.\n",
+              stderr);
+        return 1;
+    }
+
+    GLFWwindow *window;
+    init(&window);
+
+    // In bench mode, every configuration sees the same camera path, and the
+    // first few frames after a switch aren't counted.
+    const unsigned benchFrames = 300, warmupFrames = 20;
+    unsigned frame = 0, configFrame = 0;
+    int lastConfig = currentConfig();
+    double lastTime = glfwGetTime();
+
+    do {
+        int slot = beginQueries(frame);
+        double sortSeconds = drawFrame(configFrame * 0.005f, slot);
+        glEndQuery(GL_TIME_ELAPSED);
+
+        // Swap buffers
+        glfwSwapBuffers(window);
+        reportStartupTime();
+        glfwPollEvents();
+
+        double now = glfwGetTime();
+        ConfigStats &stats = scene.stats[lastConfig];
+        if (!scene.overdraw && (!bench || configFrame >= warmupFrames)) {
+            stats.frames++;
+            stats.cpuSeconds += now - lastTime;
+            stats.sortSeconds += sortSeconds;
+        }
+        lastTime = now;
+        frame++;
+        configFrame++;
+        if (currentConfig() != lastConfig) {
+            lastConfig = currentConfig();
+            if (bench)
+                configFrame = 0;
+        }
+
+        if (bench && configFrame == warmupFrames + benchFrames) {
+            if (lastConfig + 1 == configCount)
+                break;
+            lastConfig++;
+            scene.prePass = lastConfig / SORT_MODE_COUNT;
+            scene.sort = (SortMode)(lastConfig % SORT_MODE_COUNT);
+            configFrame = 0;
+            printConfig();
+        }
+
+        // Check if the ESC key was pressed or the window was closed
+    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+             !glfwWindowShouldClose(window));
+
+    printStats(window);
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}
@@ -0,0 +1,5 @@
+#version 330 core
+
+void main() {
+    // Nothing to do: the depth pre-pass only writes depth.
+}
@@ -0,0 +1,19 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec3 fragmentColor;
+
+// Output data
+out vec3 color;
+
+// Stand-in for an expensive material: how many rounds of busywork to do per
+// fragment. It's a uniform so the compiler can't fold the loop away.
+uniform int iterations;
+
+void main() {
+    float v = 0;
+    for (int i = 0; i < iterations; i++)
+        v += sin(dot(gl_FragCoord.xy, vec2(12.9898, 78.233)) * (i+1) * 1e-3 + v);
+
+    color = fragmentColor * (0.75 + 0.25 * fract(v));
+}
@@ -0,0 +1,27 @@
+#version 330 core
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 1) in vec3 vertexColor;
+// Input instance data, different for each cube.
+layout(location = 2) in vec3 instanceOffset_worldspace;
+
+// Output data; will be interpolated for each fragment.
+out vec3 fragmentColor;
+// Values that stay constant for the whole mesh.
+uniform mat4 VP;
+uniform float cubeScale;
+
+// The depth pre-pass and the shading pass must produce bit-identical depths
+// for GL_EQUAL to pass, so don't let the compiler reorder this maths.
+invariant gl_Position;
+
+void main() {
+    vec3 position_worldspace =
+        vertexPosition_modelspace * cubeScale + instanceOffset_worldspace;
+    gl_Position = VP * vec4(position_worldspace, 1);
+
+    // The color of each vertex will be interpolated
+    // to produce the color of each fragment
+    fragmentColor = vertexColor;
+}
@@ -0,0 +1,10 @@
+#version 330 core
+
+// Output data
+out vec3 color;
+
+void main() {
+    // Added up over every fragment shaded at a pixel: red saturates after 8,
+    // yellow after 16 and white after 32.
+    color = vec3(1.0 / 8, 1.0 / 16, 1.0 / 32);
+}
@@ -0,0 +1,429 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../common/gltrace.h"
+#include "../common/startup-time.h"
+#include "shader-variants.hpp"
+#include "shaders.h"
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+// Our vertices. Three consecutive floats give a 3D vertex; Three consecutive
+// vertices give a triangle. A cube has 6 faces with 2 triangles each, so this
+// makes 6*2=12 triangles, and 12*3 vertices
+static const GLfloat cubeVertexData[] = {
+    -1.0f,-1.0f,-1.0f,
+    -1.0f,-1.0f, 1.0f,
+    -1.0f, 1.0f, 1.0f,
+     1.0f, 1.0f,-1.0f,
+    -1.0f,-1.0f,-1.0f,
+    -1.0f, 1.0f,-1.0f,
+     1.0f,-1.0f, 1.0f,
+    -1.0f,-1.0f,-1.0f,
+     1.0f,-1.0f,-1.0f,
+     1.0f, 1.0f,-1.0f,
+     1.0f,-1.0f,-1.0f,
+    -1.0f,-1.0f,-1.0f,
+    -1.0f,-1.0f,-1.0f,
+    -1.0f, 1.0f, 1.0f,
+    -1.0f, 1.0f,-1.0f,
+     1.0f,-1.0f, 1.0f,
+    -1.0f,-1.0f, 1.0f,
+    -1.0f,-1.0f,-1.0f,
+    -1.0f, 1.0f, 1.0f,
+    -1.0f,-1.0f, 1.0f,
+     1.0f,-1.0f, 1.0f,
+     1.0f, 1.0f, 1.0f,
+     1.0f,-1.0f,-1.0f,
+     1.0f, 1.0f,-1.0f,
+     1.0f,-1.0f,-1.0f,
+     1.0f, 1.0f, 1.0f,
+     1.0f,-1.0f, 1.0f,
+     1.0f, 1.0f, 1.0f,
+     1.0f, 1.0f,-1.0f,
+    -1.0f, 1.0f,-1.0f,
+     1.0f, 1.0f, 1.0f,
+    -1.0f, 1.0f,-1.0f,
+    -1.0f, 1.0f, 1.0f,
+     1.0f, 1.0f, 1.0f,
+    -1.0f, 1.0f, 1.0f,
+     1.0f,-1.0f, 1.0f
+};
+
+// One color for each vertex. They were generated randomly.
+static const GLfloat cubeColourData[] = {
+    0.583f,  0.771f,  0.014f,
+    0.609f,  0.115f,  0.436f,
+    0.327f,  0.483f,  0.844f,
+    0.822f,  0.569f,  0.201f,
+    0.435f,  0.602f,  0.223f,
+    0.310f,  0.747f,  0.185f,
+    0.597f,  0.770f,  0.761f,
+    0.559f,  0.436f,  0.730f,
+    0.359f,  0.583f,  0.152f,
+    0.483f,  0.596f,  0.789f,
+    0.559f,  0.861f,  0.639f,
+    0.195f,  0.548f,  0.859f,
+    0.014f,  0.184f,  0.576f,
+    0.771f,  0.328f,  0.970f,
+    0.406f,  0.615f,  0.116f,
+    0.676f,  0.977f,  0.133f,
+    0.971f,  0.572f,  0.833f,
+    0.140f,  0.616f,  0.489f,
+    0.997f,  0.513f,  0.064f,
+    0.945f,  0.719f,  0.592f,
+    0.543f,  0.021f,  0.978f,
+    0.279f,  0.317f,  0.505f,
+    0.167f,  0.620f,  0.077f,
+    0.347f,  0.857f,  0.137f,
+    0.055f,  0.953f,  0.042f,
+    0.714f,  0.505f,  0.345f,
+    0.783f,  0.290f,  0.734f,
+    0.722f,  0.645f,  0.174f,
+    0.302f,  0.455f,  0.848f,
+    0.225f,  0.587f,  0.040f,
+    0.517f,  0.713f,  0.338f,
+    0.053f,  0.959f,  0.120f,
+    0.393f,  0.621f,  0.362f,
+    0.673f,  0.211f,  0.457f,
+    0.820f,  0.883f,  0.371f,
+    0.982f,  0.099f,  0.879f
+};
+
+static const int cubeVertexCount = 12*3;
+
+// A cube of cubes, gridSize on a side
+static const int gridSize = 12,
+                 instanceCount = gridSize * gridSize * gridSize;
+static const float gridSpacing = 2, cubeScale = 0.5f;
+
+// Dark blue background, which the fog fades to
+static const glm::vec3 backgroundColour(0.0f, 0.0f, 0.4f);
+
+// Uniform locations of one variant. Ones the variant doesn't use are -1, which
+// glUniform* quietly ignores.
+struct VariantUniforms {
+    GLint vp, v, offset;
+};
+
+static struct {
+    // Which features are switched on; the key of the variant to draw with
+    VariantKey features;
+    bool prePass;
+
+    ShaderVariants variants;
+    VariantUniforms uniforms[variantCount];
+
+    GLuint floatVAOID, quantizedVAOID;
+    // Model units per step of the quantized positions
+    float positionStep;
+    glm::vec3 offsets[instanceCount];
+} scene;
+
+static void printFeatures() {
+    printf("Drawing with the %s variant%s\n",
+        variantName(scene.features).c_str(),
+        scene.prePass ? ", after a depth pre-pass" : "");
+}
+
+// Make a VBO from data and point the given attribute at it.
+static void attribBuffer(GLuint vaaID, const void *data, GLsizeiptr size,
+                         GLint components, GLenum type, GLboolean normalized) {
+    GLuint vboID;
+    glGenBuffers(1, &vboID);
+    glBindBuffer(GL_ARRAY_BUFFER, vboID);
+    glBufferData(GL_ARRAY_BUFFER, size, data, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(vaaID);
+    glVertexAttribPointer(vaaID, components, type, normalized, 0, NULL);
+}
+
+static void instanceAttribs(GLuint instanceVBOID) {
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBOID);
+    // 3rd attribute buffer: cube positions, advancing once per instance
+    const GLuint offsetVAAID = 2;
+    glEnableVertexAttribArray(offsetVAAID);
+    glVertexAttribPointer(offsetVAAID, 3, GL_FLOAT, GL_FALSE, 0, NULL);
+    glVertexAttribDivisor(offsetVAAID, 1);
+}
+
+// Two VAOs for the same cubes: one with full floats, and one with positions as
+// shorts and colours as normalized bytes, for the quantized variants. The
+// shorts count steps of scene.positionStep, which the shader multiplies back
+// in; the largest coordinate is 32767 steps.
+static void cubeAttribs() {
+    const float half = (gridSize - 1) * gridSpacing / 2;
+    for (int i = 0; i < instanceCount; i++)
+        scene.offsets[i] = glm::vec3(
+            i % gridSize, i / gridSize % gridSize, i / gridSize / gridSize)
+            * gridSpacing - glm::vec3(half);
+    GLuint instanceVBOID;
+    glGenBuffers(1, &instanceVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBOID);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(scene.offsets), scene.offsets,
+        GL_STATIC_DRAW);
+
+    glGenVertexArrays(1, &scene.floatVAOID);
+    glBindVertexArray(scene.floatVAOID);
+    attribBuffer(0, cubeVertexData, sizeof(cubeVertexData), 3, GL_FLOAT,
+        GL_FALSE);
+    attribBuffer(1, cubeColourData, sizeof(cubeColourData), 3, GL_FLOAT,
+        GL_FALSE);
+    instanceAttribs(instanceVBOID);
+
+    const int n = cubeVertexCount * 3;
+    float extent = 0;
+    for (int i = 0; i < n; i++)
+        extent = fmaxf(extent, fabsf(cubeVertexData[i]));
+    scene.positionStep = extent / 32767;
+    GLshort positions[n];
+    GLubyte colours[n];
+    for (int i = 0; i < n; i++) {
+        positions[i] = (GLshort)lroundf(cubeVertexData[i]
+                                        / scene.positionStep);
+        colours[i] = (GLubyte)lroundf(cubeColourData[i] * 255);
+    }
+    glGenVertexArrays(1, &scene.quantizedVAOID);
+    glBindVertexArray(scene.quantizedVAOID);
+    attribBuffer(0, positions, sizeof(positions), 3, GL_SHORT, GL_FALSE);
+    attribBuffer(1, colours, sizeof(colours), 3, GL_UNSIGNED_BYTE, GL_TRUE);
+    instanceAttribs(instanceVBOID);
+}
+
+// Embedded at build time, unless SHADER_DIR says to read it from disk. Sets
+// *hash to the hash of the source, for the program cache; an embedded
+// shader's was worked out at build time.
+static std::string cubeShaderSource(const char *fn, uint32_t *hash) {
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    *hash = allocated ? shaderHash(source, size)
+                      : findEmbeddedShader(embeddedShaders,
+                            embeddedShaderCount, fn)->sourceHash;
+    std::string result(source, size);
+    free(allocated);
+    return result;
+}
+
+// Returns false if any variant failed, leaving the ones from before in use
+static bool compileVariants() {
+    const char *vertex_fn = "cube-vertex.glsl",
+               *fragment_fn = "cube-fragment.glsl";
+    uint32_t vertexHash, fragmentHash;
+    std::string vertex = cubeShaderSource(vertex_fn, &vertexHash),
+                fragment = cubeShaderSource(fragment_fn, &fragmentHash);
+    double start = glfwGetTime();
+    if (scene.variants.compileAll(vertex_fn, vertex, vertexHash,
+            fragment_fn, fragment, fragmentHash)) {
+        fputs("Failed to compile shader variants\n", stderr);
+        return false;
+    }
+    printf("Compiled %d of %d shader variants in %.1f ms; the rest were "
+        "cached\n", scene.variants.compiledLastTime(), variantCount,
+        1e3 * (glfwGetTime() - start));
+
+    // Set the uniforms that never change, and remember where the rest are
+    for (int slot = 0; slot < variantCount; slot++) {
+        GLuint programID = scene.variants.get(variantKeys[slot]);
+        glUseProgram(programID);
+        glUniform1f(glGetUniformLocation(programID, "cubeScale"), cubeScale);
+        glUniform1f(glGetUniformLocation(programID, "positionScale"),
+            scene.positionStep);
+        glUniform3fv(glGetUniformLocation(programID, "fogColor"), 1,
+            &backgroundColour[0]);
+        glUniform1f(glGetUniformLocation(programID, "fogDensity"), 0.02f);
+
+        VariantUniforms &uniforms = scene.uniforms[slot];
+        uniforms.vp = glGetUniformLocation(programID, "VP");
+        uniforms.v = glGetUniformLocation(programID, "V");
+        uniforms.offset = glGetUniformLocation(programID,
+            "instanceOffset_worldspace");
+    }
+    return true;
+}
+
+static void keyCallback(GLFWwindow *window, int key, int scancode,
+                        int action, int mods) {
+    if (action != GLFW_PRESS)
+        return;
+    VariantKey toggle;
+    switch (key) {
+    case GLFW_KEY_I: toggle = FEATURE_INSTANCED; break;
+    case GLFW_KEY_Q: toggle = FEATURE_QUANTIZED; break;
+    case GLFW_KEY_O: toggle = FEATURE_OVERDRAW;  break;
+    case GLFW_KEY_F: toggle = FEATURE_FOG;       break;
+    case GLFW_KEY_P:
+        scene.prePass = !scene.prePass;
+        printFeatures();
+        return;
+    case GLFW_KEY_R:
+        // Run with SHADER_DIR=. to pick up edits; only variants of changed
+        // sources are compiled again. If any fail, the last good ones stay.
+        if (!compileVariants())
+            puts("Shader reload failed; keeping the previous variants");
+        return;
+    default:
+        return;
+    }
+    // Switching on a feature turns off any it can't be combined with
+    VariantKey features = scene.features ^ toggle;
+    for (const FeatureInfo &info: featureInfos)
+        if (info.feature == toggle && (features & toggle))
+            features &= ~info.excludes;
+    scene.features = features;
+    printFeatures();
+}
+
+static void init(GLFWwindow **window) {
+    // Set error callback to see more detailed failure info
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    glfwWindowHint(GLFW_SAMPLES, 4); // 4x antialiasing
+
+    // To ensure compatiblity, check the output of this command:
+    // $ glxinfo | grep 'Max core profile version'
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+    // To make MacOS happy
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // We don't want the old OpenGL
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Open a window and create its OpenGL context
+    *window = glfwCreateWindow(1024, 768,
+        "Tutorial 07 - Shader variants", NULL, NULL);
+    if (!*window) {
+        fputs("Failed to open GLFW window.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(*window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(*window, GLFW_STICKY_KEYS, GL_TRUE);
+    // I, Q, O and F toggle features; P toggles the depth pre-pass; R reloads
+    // the shaders
+    glfwSetKeyCallback(*window, keyCallback);
+
+    glClearColor(backgroundColour.x, backgroundColour.y, backgroundColour.z,
+        0.0);
+
+    // Enable depth test
+    glEnable(GL_DEPTH_TEST);
+
+    cubeAttribs();
+
+    // Every variant is compiled now, so that switching features while
+    // drawing never has to. There's nothing to fall back on yet if they fail.
+    if (!compileVariants())
+        exit(1);
+
+    scene.features = FEATURE_INSTANCED;
+    puts("Initialized.");
+    printFeatures();
+}
+
+static void drawCubes(VariantKey features, const glm::mat4 &vp,
+                      const glm::mat4 &view) {
+    // The lookup is an array index; nothing is compiled here
+    glUseProgram(scene.variants.get(features));
+    const VariantUniforms &uniforms = scene.uniforms[variantSlots[features]];
+    glUniformMatrix4fv(uniforms.vp, 1, GL_FALSE, &vp[0][0]);
+    glUniformMatrix4fv(uniforms.v, 1, GL_FALSE, &view[0][0]);
+
+    glBindVertexArray(features & FEATURE_QUANTIZED ?
+        scene.quantizedVAOID : scene.floatVAOID);
+    if (features & FEATURE_INSTANCED)
+        glDrawArraysInstanced(GL_TRIANGLES, 0, cubeVertexCount,
+            instanceCount);
+    else
+        // One draw call per cube, with its position in a uniform
+        for (int i = 0; i < instanceCount; i++) {
+            glUniform3fv(uniforms.offset, 1, &scene.offsets[i][0]);
+            glDrawArrays(GL_TRIANGLES, 0, cubeVertexCount);
+        }
+}
+
+static void drawFrame(float angle) {
+    // Orbit the camera around the grid
+    const float radius = gridSize * gridSpacing * 1.2f;
+    glm::mat4 projection = glm::perspective(
+        glm::radians(45.f), 4.f/3, 0.1f, 200.f);
+    glm::mat4 view = glm::lookAt(
+        glm::vec3(radius*cosf(angle), radius*0.6f, radius*sinf(angle)),
+        glm::vec3(0, 0, 0),
+        glm::vec3(0, 1, 0)
+    );
+    glm::mat4 vp = projection * view;
+
+    // Clear the screen. Depth writes must be on for this to clear depth.
+    glDepthMask(GL_TRUE);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // Accept fragment if it's closer to the camera than the former one
+    glDepthFunc(GL_LESS);
+    if (scene.prePass) {
+        // Same vertex features, so the depths match exactly
+        VariantKey vertexFeatures = scene.features &
+            (FEATURE_INSTANCED | FEATURE_QUANTIZED);
+        glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        drawCubes(vertexFeatures | FEATURE_DEPTH_ONLY, vp, view);
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthMask(GL_FALSE);
+        glDepthFunc(GL_EQUAL);
+    }
+
+    if (scene.features & FEATURE_OVERDRAW) {
+        glEnable(GL_BLEND);
+        glBlendFunc(GL_ONE, GL_ONE);
+    }
+    drawCubes(scene.features, vp, view);
+    glDisable(GL_BLEND);
+}
+
+int main() {
+    markMainStart();
+
+    GLFWwindow *window;
+    init(&window);
+
+    do {
+        drawFrame(glfwGetTime() * 0.3f);
+
+        // Swap buffers
+        glfwSwapBuffers(window);
+        reportStartupTime();
+        glfwPollEvents();
+
+        // Check if the ESC key was pressed or the window was closed
+    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+             !glfwWindowShouldClose(window));
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}
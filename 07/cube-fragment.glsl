@@ -0,0 +1,33 @@
+#version 330 core
+// Feature #defines are inserted after the #version line when each variant is
+// compiled; see shader-variants.hpp for which combinations exist.
+
+#ifndef FEATURE_DEPTH_ONLY
+// Interpolated values from the vertex shaders
+in vec3 fragmentColor;
+
+// Output data
+out vec3 color;
+#endif
+
+#ifdef FEATURE_FOG
+in float viewDepth;
+
+uniform vec3 fogColor;
+uniform float fogDensity;
+#endif
+
+void main() {
+#if defined(FEATURE_DEPTH_ONLY)
+    // Nothing to do: only depth is written.
+#elif defined(FEATURE_OVERDRAW)
+    // Added up over every fragment shaded at a pixel: red saturates after 8,
+    // yellow after 16 and white after 32.
+    color = vec3(1.0 / 8, 1.0 / 16, 1.0 / 32);
+#elif defined(FEATURE_FOG)
+    float visibility = exp(-fogDensity * viewDepth);
+    color = mix(fogColor, fragmentColor, visibility);
+#else
+    color = fragmentColor;
+#endif
+}
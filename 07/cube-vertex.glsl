@@ -0,0 +1,55 @@
+#version 330 core
+// Feature #defines are inserted after the #version line when each variant is
+// compiled; see shader-variants.hpp for which combinations exist.
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 1) in vec3 vertexColor;
+#ifdef FEATURE_INSTANCED
+// Input instance data, different for each cube.
+layout(location = 2) in vec3 instanceOffset_worldspace;
+#else
+// Set before drawing each cube.
+uniform vec3 instanceOffset_worldspace;
+#endif
+
+// Output data; will be interpolated for each fragment.
+#ifndef FEATURE_DEPTH_ONLY
+out vec3 fragmentColor;
+#endif
+#ifdef FEATURE_FOG
+out float viewDepth;
+#endif
+
+// Values that stay constant for the whole mesh.
+uniform mat4 VP;
+uniform float cubeScale;
+#ifdef FEATURE_FOG
+uniform mat4 V;
+#endif
+#ifdef FEATURE_QUANTIZED
+// Positions arrive as whole numbers of steps, from shorts that aren't
+// normalized; this is the size of a step in model units.
+uniform float positionScale;
+#endif
+
+// A depth-only variant and a shading variant must produce bit-identical depths
+// for GL_EQUAL to pass.
+invariant gl_Position;
+
+void main() {
+    vec3 position_modelspace = vertexPosition_modelspace;
+#ifdef FEATURE_QUANTIZED
+    position_modelspace *= positionScale;
+#endif
+    vec3 position_worldspace =
+        position_modelspace * cubeScale + instanceOffset_worldspace;
+    gl_Position = VP * vec4(position_worldspace, 1);
+
+#ifndef FEATURE_DEPTH_ONLY
+    fragmentColor = vertexColor;
+#endif
+#ifdef FEATURE_FOG
+    viewDepth = -(V * vec4(position_worldspace, 1)).z;
+#endif
+}
@@ -0,0 +1,290 @@
+#ifndef SHADER_VARIANTS_HPP
+#define SHADER_VARIANTS_HPP
+
+// Shader variants: one pair of GLSL sources, compiled once for every valid
+// combination of features. Each feature is a #define that the sources test
+// with #ifdef, so a variant contains only the code it needs and never branches
+// on features at runtime.
+//
+// The table below is the single description of which features exist and which
+// can't be combined. Both the variants build tool (which compiles every
+// combination to check it) and the program (which compiles them all at
+// startup and looks them up by key) are built from it.
+//
+// Compiled programs are cached by the hashes of both sources and the variant
+// key, so compiling again after a reload only redoes what changed.
+
+#include <ctype.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <array>
+#include <map>
+#include <string>
+#include <tuple>
+
+#include <GL/glew.h>
+
+// A variant is identified by the OR of its features.
+typedef uint32_t VariantKey;
+
+enum Feature : VariantKey {
+    FEATURE_INSTANCED  = 1 << 0, // Cube offsets are a per-instance attribute
+    FEATURE_QUANTIZED  = 1 << 1, // Positions are shorts, scaled in the shader
+    FEATURE_DEPTH_ONLY = 1 << 2, // No colour output, for a depth pre-pass
+    FEATURE_OVERDRAW   = 1 << 3, // Constant colour to add up per pixel
+    FEATURE_FOG        = 1 << 4, // Fade to the fog colour with view depth
+};
+
+static const int featureCount = 5;
+
+struct FeatureInfo {
+    Feature feature;
+    // Name of the #define, which is also how the sources refer to it
+    const char *define;
+    // Features that can't be combined with this one
+    VariantKey excludes;
+};
+
+constexpr FeatureInfo featureInfos[featureCount] = {
+    {FEATURE_INSTANCED,  "FEATURE_INSTANCED",  0},
+    {FEATURE_QUANTIZED,  "FEATURE_QUANTIZED",  0},
+    {FEATURE_DEPTH_ONLY, "FEATURE_DEPTH_ONLY", FEATURE_OVERDRAW | FEATURE_FOG},
+    {FEATURE_OVERDRAW,   "FEATURE_OVERDRAW",   FEATURE_DEPTH_ONLY |
+                                               FEATURE_FOG},
+    {FEATURE_FOG,        "FEATURE_FOG",        FEATURE_DEPTH_ONLY |
+                                               FEATURE_OVERDRAW},
+};
+
+// One more than the largest key
+constexpr VariantKey variantKeyLimit = 1u << featureCount;
+
+constexpr bool isValidVariant(VariantKey key) {
+    if (key >= variantKeyLimit)
+        return false;
+    for (const FeatureInfo &info: featureInfos)
+        if ((key & info.feature) && (key & info.excludes))
+            return false;
+    return true;
+}
+
+constexpr int countVariants() {
+    int count = 0;
+    for (VariantKey key = 0; key < variantKeyLimit; key++)
+        count += isValidVariant(key);
+    return count;
+}
+
+constexpr int variantCount = countVariants();
+
+constexpr std::array<VariantKey, variantCount> listVariants() {
+    std::array<VariantKey, variantCount> keys = {};
+    int slot = 0;
+    for (VariantKey key = 0; key < variantKeyLimit; key++)
+        if (isValidVariant(key))
+            keys[slot++] = key;
+    return keys;
+}
+
+// Every valid key, in the order their programs are stored
+constexpr std::array<VariantKey, variantCount> variantKeys = listVariants();
+
+constexpr std::array<int, variantKeyLimit> listSlots() {
+    std::array<int, variantKeyLimit> slots = {};
+    for (VariantKey key = 0; key < variantKeyLimit; key++)
+        slots[key] = -1;
+    for (int slot = 0; slot < variantCount; slot++)
+        slots[variantKeys[slot]] = slot;
+    return slots;
+}
+
+// Where each key's program is stored, or -1 for combinations that don't exist
+constexpr std::array<int, variantKeyLimit> variantSlots = listSlots();
+
+// The slot of a key known at compile time. Asking for a combination that
+// doesn't exist is a compile error rather than a runtime one.
+template <VariantKey Key>
+constexpr int variantSlot() {
+    static_assert(isValidVariant(Key), "no such shader variant");
+    return variantSlots[Key];
+}
+
+static_assert(variantSlot<0>() == 0, "the base variant comes first");
+
+// Readable name for log messages, e.g. "instanced+fog"
+inline std::string variantName(VariantKey key) {
+    std::string name;
+    for (const FeatureInfo &info: featureInfos) {
+        if (!(key & info.feature))
+            continue;
+        if (!name.empty())
+            name += '+';
+        // Drop the "FEATURE_" prefix and lowercase the rest
+        for (const char *c = info.define + 8; *c; c++)
+            name += *c == '_' ? '-' : (char)tolower(*c);
+    }
+    return name.empty() ? "base" : name;
+}
+
+// The source of a variant: the #version line, which must stay first, then a
+// #define for each feature, then the rest of the file with its line numbers
+// kept so that compile messages still point at the right line.
+inline std::string variantSource(VariantKey key, const std::string &source) {
+    size_t versionEnd = source.find('\n') + 1;
+    std::string result = source.substr(0, versionEnd);
+    for (const FeatureInfo &info: featureInfos)
+        if (key & info.feature) {
+            result += "#define ";
+            result += info.define;
+            result += " 1\n";
+        }
+    result += "#line 2\n";
+    result += source.substr(versionEnd);
+    return result;
+}
+
+// Compile one stage of a variant. Returns 0 on failure, after printing the log.
+inline GLuint compileVariantShader(VariantKey key, const char *fn,
+                                   const std::string &source,
+                                   GLenum shaderType) {
+    GLuint shaderID = glCreateShader(shaderType);
+    if (!shaderID) {
+        fprintf(stderr, "Failed to create shader\n");
+        exit(1);
+    }
+
+    std::string variant = variantSource(key, source);
+    const GLchar *rosource = variant.c_str();
+    glShaderSource(shaderID, 1, &rosource, NULL);
+    glCompileShader(shaderID);
+
+    GLint logLength;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 1) {
+        std::string log(logLength, '\0');
+        glGetShaderInfoLog(shaderID, logLength, NULL, &log[0]);
+        printf("Shader compile message for '%s' (%s): %s\n", fn,
+            variantName(key).c_str(), log.c_str());
+    }
+
+    GLint status;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+    if (!status) {
+        glDeleteShader(shaderID);
+        return 0;
+    }
+    return shaderID;
+}
+
+// Compile and link one variant. Returns 0 on failure, after printing the logs.
+inline GLuint linkVariant(VariantKey key,
+                          const char *vertex_fn, const std::string &vertex,
+                          const char *fragment_fn,
+                          const std::string &fragment) {
+    GLuint vertexShaderID = compileVariantShader(
+               key, vertex_fn, vertex, GL_VERTEX_SHADER),
+           fragmentShaderID = compileVariantShader(
+               key, fragment_fn, fragment, GL_FRAGMENT_SHADER);
+    if (!vertexShaderID || !fragmentShaderID) {
+        glDeleteShader(vertexShaderID);
+        glDeleteShader(fragmentShaderID);
+        return 0;
+    }
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    glLinkProgram(programID);
+
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 1) {
+        std::string log(logLength, '\0');
+        glGetProgramInfoLog(programID, logLength, NULL, &log[0]);
+        printf("Shader link message (%s): %s\n", variantName(key).c_str(),
+            log.c_str());
+    }
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status) {
+        glDeleteProgram(programID);
+        return 0;
+    }
+    return programID;
+}
+
+// Every variant's program, compiled up front and then looked up by key.
+class ShaderVariants {
+public:
+    // Make every valid variant of the given sources current, compiling and
+    // linking those not already cached under the sources' hashes (the
+    // sourceHash of an embedded shader, or shaderHash() of one read from
+    // disk). Returns how many failed; if any did, the variants from before
+    // stay current.
+    int compileAll(const char *vertex_fn, const std::string &vertex,
+                   uint32_t vertexHash, const char *fragment_fn,
+                   const std::string &fragment, uint32_t fragmentHash) {
+        GLuint compiled[variantCount];
+        int failures = 0;
+        lastCompiled = 0;
+        for (int slot = 0; slot < variantCount; slot++) {
+            CacheKey key(vertexHash, fragmentHash, variantKeys[slot]);
+            auto cached = cache.find(key);
+            if (cached != cache.end()) {
+                compiled[slot] = cached->second;
+                continue;
+            }
+            compiled[slot] = linkVariant(variantKeys[slot],
+                vertex_fn, vertex, fragment_fn, fragment);
+            if (!compiled[slot]) {
+                failures++;
+                continue;
+            }
+            cache[key] = compiled[slot];
+            lastCompiled++;
+        }
+        if (!failures)
+            std::copy(compiled, compiled + variantCount, programIDs);
+        return failures;
+    }
+
+    // How many variants the last compileAll() had to compile, rather than
+    // finding in the cache
+    int compiledLastTime() const {
+        return lastCompiled;
+    }
+
+    // Look up a variant whose features are only known at runtime
+    GLuint get(VariantKey key) const {
+        int slot = key < variantKeyLimit ? variantSlots[key] : -1;
+        if (slot < 0) {
+            fprintf(stderr, "No shader variant %s\n", variantName(key).c_str());
+            exit(1);
+        }
+        return programIDs[slot];
+    }
+
+    // Look up a variant whose features are fixed at compile time
+    template <VariantKey Key>
+    GLuint get() const {
+        return programIDs[variantSlot<Key>()];
+    }
+
+private:
+    // Vertex source hash, fragment source hash, variant
+    typedef std::tuple<uint32_t, uint32_t, VariantKey> CacheKey;
+
+    GLuint programIDs[variantCount] = {};
+    std::map<CacheKey, GLuint> cache;
+    int lastCompiled = 0;
+};
+
+#endif
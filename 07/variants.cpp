@@ -0,0 +1,140 @@
+// Build step for tutorial 07: writes out the full source of every shader
+// variant under glsl-variants/, and checks that each one compiles and links.
+// glsl-variants/index.txt is only written once they all have, so make
+// variants-check reruns this until they do. The program doesn't read these
+// files; they're for looking at what each variant actually compiles.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "../common/embedded-shaders.h"
+#include "shader-variants.hpp"
+
+static const char *const vertex_fn = "cube-vertex.glsl",
+                  *const fragment_fn = "cube-fragment.glsl";
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+// A source that tests a FEATURE_ name that isn't in the feature table would
+// compile fine, with that code silently never included. Count those.
+static int checkFeatureNames(const char *fn, const std::string &source) {
+    int unknown = 0;
+    for (size_t pos = source.find("FEATURE_"); pos != std::string::npos;
+         pos = source.find("FEATURE_", pos + 1)) {
+        size_t end = pos;
+        while (end < source.size() &&
+               (isalnum((unsigned char)source[end]) || source[end] == '_'))
+            end++;
+        std::string name = source.substr(pos, end - pos);
+
+        bool found = false;
+        for (const FeatureInfo &info: featureInfos)
+            found |= name == info.define;
+        if (!found) {
+            fprintf(stderr, "%s: unknown feature %s\n", fn, name.c_str());
+            unknown++;
+        }
+    }
+    return unknown;
+}
+
+static void writeFile(const std::string &fn, const std::string &contents) {
+    FILE *f = fopen(fn.c_str(), "w");
+    if (!f || fwrite(contents.data(), 1, contents.size(), f)
+              != contents.size()) {
+        perror(fn.c_str());
+        exit(1);
+    }
+    if (fclose(f)) {
+        perror(fn.c_str());
+        exit(1);
+    }
+}
+
+// Only compiling needs a context, so it doesn't need to be visible.
+static void init() {
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    GLFWwindow *window = glfwCreateWindow(64, 64, "variants", NULL, NULL);
+    if (!window) {
+        fputs("Failed to create a GL context to check variants with.\n",
+            stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+}
+
+// This checks the sources on disk, before they're embedded in the program.
+static std::string readSource(const char *fn) {
+    int size;
+    char *source = readShaderFile(".", fn, &size);
+    std::string result(source, size);
+    free(source);
+    return result;
+}
+
+int main() {
+    std::string vertex = readSource(vertex_fn),
+                fragment = readSource(fragment_fn);
+    int failures = checkFeatureNames(vertex_fn, vertex)
+                 + checkFeatureNames(fragment_fn, fragment);
+
+    init();
+
+    std::string index;
+    for (VariantKey key: variantKeys) {
+        std::string name = variantName(key);
+        writeFile("glsl-variants/" + name + "." + vertex_fn,
+            variantSource(key, vertex));
+        writeFile("glsl-variants/" + name + "." + fragment_fn,
+            variantSource(key, fragment));
+
+        GLuint programID = linkVariant(key, vertex_fn, vertex,
+            fragment_fn, fragment);
+        if (programID) {
+            glDeleteProgram(programID);
+            printf("%-28s ok\n", name.c_str());
+        } else {
+            printf("%-28s FAILED\n", name.c_str());
+            failures++;
+        }
+        index += std::to_string(key) + " " + name + "\n";
+    }
+
+    glfwTerminate();
+
+    if (failures) {
+        fprintf(stderr, "%d shader variant problem(s)\n", failures);
+        return 1;
+    }
+    writeFile("glsl-variants/index.txt", index);
+    printf("All %d shader variants compiled and linked.\n", variantCount);
+    return 0;
+}
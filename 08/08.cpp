@@ -0,0 +1,524 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <optional>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../common/gltrace.h"
+// Count heap allocations, so the render loop can check it makes none
+#define COUNT_HEAP_ALLOCATIONS
+#include "../common/memory.hpp"
+#include "../common/startup-time.h"
+#include "shaders.h"
+
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+static GLuint loadShader(const char *fn, GLenum shaderType) {
+    printf("Compiling shader '%s'...\n", fn);
+
+    GLuint shaderID = glCreateShader(shaderType);
+    if (!shaderID) {
+        fprintf(stderr, "Failed to create shader\n");
+        exit(1);
+    }
+
+    // Embedded at build time, unless SHADER_DIR says to read it from disk
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    glShaderSource(shaderID, 1, &source, &size);
+    free(allocated);
+
+    glCompileShader(shaderID);
+
+    GLint logLength;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength) {
+        GLchar *log = (GLchar*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetShaderInfoLog(shaderID, logLength, NULL, log);
+        printf("Shader compile message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    return shaderID;
+}
+
+static GLuint loadShaders(const char *vertex_fn, const char *fragment_fn) {
+    // Compile the shaders
+    GLuint vertexShaderID = loadShader(vertex_fn, GL_VERTEX_SHADER),
+           fragmentShaderID = loadShader(fragment_fn, GL_FRAGMENT_SHADER);
+
+    puts("Linking shader program...");
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    glLinkProgram(programID);
+
+    // Check the program
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0) {
+        char *log = (char*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetProgramInfoLog(programID, logLength, NULL, log);
+        printf("Shader link message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    return programID;
+}
+
+static void vertexAttribs() {
+    // Our vertices. Three consecutive floats give a 3D vertex; Three
+    // consecutive vertices give a triangle.
+    // A cube has 6 faces with 2 triangles each, so this makes 6*2=12 triangles,
+    // and 12*3 vertices
+    static const GLfloat vertexData[] = {
+        -1.0f,-1.0f,-1.0f,
+        -1.0f,-1.0f, 1.0f,
+        -1.0f, 1.0f, 1.0f,
+         1.0f, 1.0f,-1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f, 1.0f,
+        -1.0f,-1.0f,-1.0f,
+         1.0f,-1.0f,-1.0f,
+         1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f,-1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f, 1.0f,
+        -1.0f,-1.0f, 1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f, 1.0f, 1.0f,
+        -1.0f,-1.0f, 1.0f,
+         1.0f,-1.0f, 1.0f,
+         1.0f, 1.0f, 1.0f,
+         1.0f,-1.0f,-1.0f,
+         1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f,-1.0f,
+         1.0f, 1.0f, 1.0f,
+         1.0f,-1.0f, 1.0f,
+         1.0f, 1.0f, 1.0f,
+         1.0f, 1.0f,-1.0f,
+        -1.0f, 1.0f,-1.0f,
+         1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f,-1.0f,
+        -1.0f, 1.0f, 1.0f,
+         1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f, 1.0f,
+         1.0f,-1.0f, 1.0f
+    };
+    // Make the VBO and add it to the VAO.
+    GLuint vertexVBOID;
+    glGenBuffers(1, &vertexVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexVBOID);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData,
+        GL_STATIC_DRAW);
+    // 1st attribute buffer: vertices
+    const GLuint vertexVAAID = 0;
+    glEnableVertexAttribArray(vertexVAAID);
+    glVertexAttribPointer(
+        vertexVAAID,  // attribute. No particular reason for 0, but must match
+                      // the layout in the shader.
+        3,            // size
+        GL_FLOAT,     // type
+        GL_FALSE,     // normalized?
+        0,            // stride
+        NULL          // array buffer offset
+    );
+}
+
+static void colourAttribs() {
+    // One color for each vertex. They were generated randomly.
+    static const GLfloat colourData[] = {
+        0.583f,  0.771f,  0.014f,
+        0.609f,  0.115f,  0.436f,
+        0.327f,  0.483f,  0.844f,
+        0.822f,  0.569f,  0.201f,
+        0.435f,  0.602f,  0.223f,
+        0.310f,  0.747f,  0.185f,
+        0.597f,  0.770f,  0.761f,
+        0.559f,  0.436f,  0.730f,
+        0.359f,  0.583f,  0.152f,
+        0.483f,  0.596f,  0.789f,
+        0.559f,  0.861f,  0.639f,
+        0.195f,  0.548f,  0.859f,
+        0.014f,  0.184f,  0.576f,
+        0.771f,  0.328f,  0.970f,
+        0.406f,  0.615f,  0.116f,
+        0.676f,  0.977f,  0.133f,
+        0.971f,  0.572f,  0.833f,
+        0.140f,  0.616f,  0.489f,
+        0.997f,  0.513f,  0.064f,
+        0.945f,  0.719f,  0.592f,
+        0.543f,  0.021f,  0.978f,
+        0.279f,  0.317f,  0.505f,
+        0.167f,  0.620f,  0.077f,
+        0.347f,  0.857f,  0.137f,
+        0.055f,  0.953f,  0.042f,
+        0.714f,  0.505f,  0.345f,
+        0.783f,  0.290f,  0.734f,
+        0.722f,  0.645f,  0.174f,
+        0.302f,  0.455f,  0.848f,
+        0.225f,  0.587f,  0.040f,
+        0.517f,  0.713f,  0.338f,
+        0.053f,  0.959f,  0.120f,
+        0.393f,  0.621f,  0.362f,
+        0.673f,  0.211f,  0.457f,
+        0.820f,  0.883f,  0.371f,
+        0.982f,  0.099f,  0.879f
+    };
+    GLuint colourVBOID;
+    glGenBuffers(1, &colourVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, colourVBOID);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(colourData), colourData,
+        GL_STATIC_DRAW);
+    // 2nd attribute buffer: colors
+    const GLuint colourVAAID = 1;
+    glEnableVertexAttribArray(colourVAAID);
+    glVertexAttribPointer(
+        colourVAAID,  // attribute. No particular reason for 1, but must match
+                      // the layout in the shader.
+        3,            // size
+        GL_FLOAT,     // type
+        GL_FALSE,     // normalized?
+        0,            // stride
+        NULL          // array buffer offset
+    );
+}
+
+// A node in the scene graph. Each one orbits and spins around its parent; the
+// leaves are cubes.
+struct SceneNode {
+    SceneNode *parent = NULL, *firstChild = NULL, *nextSibling = NULL;
+
+    float orbitRadius, orbitHeight, orbitSpeed, orbitPhase, spinSpeed;
+    // Size of the cube drawn here, or 0 for nodes that only group others
+    float cubeScale;
+
+    // Placement in the world as of the last frame
+    glm::mat4 world;
+
+    SceneNode(float orbitRadius, float orbitHeight, float orbitSpeed,
+              float orbitPhase, float spinSpeed, float cubeScale):
+        orbitRadius(orbitRadius), orbitHeight(orbitHeight),
+        orbitSpeed(orbitSpeed), orbitPhase(orbitPhase), spinSpeed(spinSpeed),
+        cubeScale(cubeScale) {}
+
+    void addChild(SceneNode *child) {
+        child->parent = this;
+        child->nextSibling = firstChild;
+        firstChild = child;
+    }
+};
+
+// Clusters of cubes in a ring around the origin
+static const int clusterCount = 48, cubesPerCluster = 256;
+static const size_t nodeCapacity = 16384;
+// Every frame's data has to fit in one of these; see the peak reported
+static const size_t arenaBytes = 4 << 20;
+
+static struct {
+    Pool<SceneNode> *nodes;
+    SceneNode *root;
+    int cubeCount;
+
+    DoubleBufferedArena *arenas;
+
+    GLuint instanceVBOID;
+    GLuint programID;
+    GLint vpID;
+} scene;
+
+static void buildScene() {
+    scene.nodes = new Pool<SceneNode>(nodeCapacity);
+    scene.root = scene.nodes->create(0, 0, 0, 0, 0, 0);
+
+    // A fixed seed, so every run draws the same scene
+    srand(8);
+    const float pi = 3.14159265f;
+    for (int c = 0; c < clusterCount; c++) {
+        SceneNode *cluster = scene.nodes->create(
+            60, 10 * sinf(c * 0.7f), 0.05f, 2*pi * c / clusterCount, 0.3f, 0);
+        scene.root->addChild(cluster);
+        for (int i = 0; i < cubesPerCluster; i++) {
+            float r = rand() / (float)RAND_MAX;
+            SceneNode *cube = scene.nodes->create(
+                3 + 9*r, 6 * (rand() / (float)RAND_MAX - 0.5f),
+                0.2f + 0.8f * (1 - r), 2*pi * rand() / RAND_MAX,
+                2 * rand() / (float)RAND_MAX, 0.15f + 0.2f * (1 - r));
+            cluster->addChild(cube);
+            scene.cubeCount++;
+        }
+    }
+}
+
+static void instanceAttribs() {
+    glGenBuffers(1, &scene.instanceVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.instanceVBOID);
+    glBufferData(GL_ARRAY_BUFFER, scene.cubeCount * sizeof(glm::mat4), NULL,
+        GL_STREAM_DRAW);
+    // 3rd-6th attribute buffers: the columns of each cube's model matrix,
+    // advancing once per instance
+    for (GLuint column = 0; column < 4; column++) {
+        const GLuint modelVAAID = 2 + column;
+        glEnableVertexAttribArray(modelVAAID);
+        glVertexAttribPointer(modelVAAID, 4, GL_FLOAT, GL_FALSE,
+            sizeof(glm::mat4), (const void*)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(modelVAAID, 1);
+    }
+}
+
+static void init(GLFWwindow **window) {
+    // Set error callback to see more detailed failure info
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    glfwWindowHint(GLFW_SAMPLES, 4); // 4x antialiasing
+
+    // To ensure compatiblity, check the output of this command:
+    // $ glxinfo | grep 'Max core profile version'
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+    // To make MacOS happy
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // We don't want the old OpenGL
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Open a window and create its OpenGL context
+    *window = glfwCreateWindow(1024, 768,
+        "Tutorial 08 - Frame memory", NULL, NULL);
+    if (!*window) {
+        fputs("Failed to open GLFW window.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(*window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(*window, GLFW_STICKY_KEYS, GL_TRUE);
+
+    // Dark blue background
+    glClearColor(0.0, 0.0, 0.4, 0.0);
+
+    // Enable depth test
+    glEnable(GL_DEPTH_TEST);
+    // Accept fragment if it's closer to the camera than the former one
+    glDepthFunc(GL_LESS);
+
+    // Everything the loop needs is allocated here, up front
+    buildScene();
+    scene.arenas = new DoubleBufferedArena(arenaBytes);
+
+    // Make the VAO.
+    GLuint vaoID;
+    glGenVertexArrays(1, &vaoID);
+    glBindVertexArray(vaoID);
+    vertexAttribs();
+    colourAttribs();
+    instanceAttribs();
+    // The VAO is ready.
+
+    // Create and compile our GLSL program from the shaders
+    scene.programID = loadShaders("node-vertex.glsl", "color-fragment.glsl");
+    // Use our shader.
+    glUseProgram(scene.programID);
+    scene.vpID = glGetUniformLocation(scene.programID, "VP");
+
+    puts("Initialized.");
+}
+
+// The six planes of the view frustum, each as (normal, distance) with the
+// normal pointing inwards, taken straight from the view-projection matrix.
+static void frustumPlanes(const glm::mat4 &vp, glm::vec4 planes[6]) {
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; r++)
+        rows[r] = glm::vec4(vp[0][r], vp[1][r], vp[2][r], vp[3][r]);
+    for (int axis = 0; axis < 3; axis++) {
+        planes[axis*2]     = rows[3] + rows[axis];
+        planes[axis*2 + 1] = rows[3] - rows[axis];
+    }
+    for (int p = 0; p < 6; p++)
+        planes[p] /= glm::length(glm::vec3(planes[p].x, planes[p].y,
+            planes[p].z));
+}
+
+static bool sphereVisible(const glm::vec4 planes[6], glm::vec3 centre,
+                          float radius) {
+    for (int p = 0; p < 6; p++)
+        if (glm::dot(glm::vec3(planes[p].x, planes[p].y, planes[p].z), centre)
+            + planes[p].w < -radius)
+            return false;
+    return true;
+}
+
+// Walk the scene graph, updating every node's placement, and collect the
+// model matrices of the cubes that can be seen. The walk's stack comes from
+// this frame's arena, like the results.
+static void visibleCubes(FrameArena &arena, float time, const glm::mat4 &vp,
+                         FrameVector<glm::mat4> &instances) {
+    glm::vec4 planes[6];
+    frustumPlanes(vp, planes);
+
+    FrameVector<SceneNode*> stack(&arena);
+    stack.reserve(scene.nodes->liveCount());
+
+    stack.push_back(scene.root);
+    while (!stack.empty()) {
+        SceneNode *node = stack.back();
+        stack.pop_back();
+
+        float orbit = node->orbitPhase + time * node->orbitSpeed;
+        glm::mat4 local = glm::translate(glm::mat4(1), glm::vec3(
+            node->orbitRadius * cosf(orbit), node->orbitHeight,
+            node->orbitRadius * sinf(orbit)));
+        local = glm::rotate(local, time * node->spinSpeed,
+            glm::vec3(0, 1, 0));
+        node->world = node->parent ? node->parent->world * local : local;
+
+        // The cube spans -1 to 1 before scaling, so sqrt(3) covers it
+        if (node->cubeScale > 0 &&
+            sphereVisible(planes, glm::vec3(node->world[3].x,
+                node->world[3].y, node->world[3].z),
+                node->cubeScale * 1.7321f))
+            instances.push_back(glm::scale(node->world,
+                glm::vec3(node->cubeScale)));
+
+        for (SceneNode *child = node->firstChild; child;
+             child = child->nextSibling)
+            stack.push_back(child);
+    }
+}
+
+static size_t drawFrame(float time) {
+    FrameArena &arena = scene.arenas->beginFrame();
+
+    glm::mat4 projection = glm::perspective(
+        glm::radians(45.f), 4.f/3, 0.1f, 300.f);
+    glm::mat4 view = glm::lookAt(
+        glm::vec3(0, 50, 110), // Above and outside the ring of clusters,
+        glm::vec3(0, 0, 20),   // looking across it
+        glm::vec3(0, 1, 0)
+    );
+    glm::mat4 vp = projection * view;
+
+    FrameVector<glm::mat4> instances(&arena);
+    instances.reserve(scene.cubeCount);
+    visibleCubes(arena, time, vp, instances);
+
+    // Orphan last frame's instance data rather than waiting for the GPU to
+    // finish with it, then upload this frame's
+    glBindBuffer(GL_ARRAY_BUFFER, scene.instanceVBOID);
+    glBufferData(GL_ARRAY_BUFFER, scene.cubeCount * sizeof(glm::mat4), NULL,
+        GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(glm::mat4),
+        instances.data());
+
+    // Clear the screen
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glUniformMatrix4fv(scene.vpID, 1, GL_FALSE, &vp[0][0]);
+    // 12*3 vertices per cube, once for every visible cube
+    glDrawArraysInstanced(GL_TRIANGLES, 0, 12*3, instances.size());
+
+    return instances.size();
+}
+
+int main() {
+    markMainStart();
+
+    GLFWwindow *window;
+    init(&window);
+
+    // Drivers may still be setting things up on the first few frames, so
+    // only check for heap allocations after that.
+    const unsigned warmupFrames = 10;
+    unsigned frame = 0;
+    double lastReport = glfwGetTime();
+
+    do {
+        {
+            std::optional<NoHeapAllocations> guard;
+            if (frame >= warmupFrames)
+                guard.emplace("the render loop");
+
+            size_t visible = drawFrame(glfwGetTime());
+
+            // Swap buffers
+            glfwSwapBuffers(window);
+            reportStartupTime();
+            glfwPollEvents();
+
+            double now = glfwGetTime();
+            if (now - lastReport >= 1) {
+                printf("%zu of %d cubes visible; arena %zu KiB this frame, "
+                    "%zu KiB peak of %zu KiB; %zu of %zu nodes\n",
+                    visible, scene.cubeCount,
+                    scene.arenas->thisFrame().bytesUsed() >> 10,
+                    scene.arenas->peakBytesUsed() >> 10, arenaBytes >> 10,
+                    scene.nodes->liveCount(), scene.nodes->countCapacity());
+                lastReport = now;
+            }
+        }
+        frame++;
+
+        // Check if the ESC key was pressed or the window was closed
+    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+             !glfwWindowShouldClose(window));
+
+    printf("Peak frame arena use: %zu KiB of %zu KiB\n",
+        scene.arenas->peakBytesUsed() >> 10, arenaBytes >> 10);
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}
@@ -0,0 +1,21 @@
+#version 330 core
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 1) in vec3 vertexColor;
+// Input instance data: each cube's model matrix, which takes up locations 2-5
+// (one per column).
+layout(location = 2) in mat4 instanceModel;
+
+// Output data; will be interpolated for each fragment.
+out vec3 fragmentColor;
+// Values that stay constant for the whole mesh.
+uniform mat4 VP;
+
+void main() {
+    gl_Position = VP * instanceModel * vec4(vertexPosition_modelspace, 1);
+
+    // The color of each vertex will be interpolated
+    // to produce the color of each fragment
+    fragmentColor = vertexColor;
+}
@@ -0,0 +1,840 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../common/command-buffer.hpp"
+#include "../common/gltrace.h"
+#include "../common/memory.hpp"
+#include "../common/startup-time.h"
+#include "shaders.h"
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+static GLuint loadShader(const char *fn, GLenum shaderType) {
+    printf("Compiling shader '%s'...\n", fn);
+
+    GLuint shaderID = glCreateShader(shaderType);
+    if (!shaderID) {
+        fprintf(stderr, "Failed to create shader\n");
+        exit(1);
+    }
+
+    // Embedded at build time, unless SHADER_DIR says to read it from disk
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    glShaderSource(shaderID, 1, &source, &size);
+    free(allocated);
+
+    glCompileShader(shaderID);
+
+    GLint logLength;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength) {
+        GLchar *log = (GLchar*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetShaderInfoLog(shaderID, logLength, NULL, log);
+        printf("Shader compile message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    return shaderID;
+}
+
+static GLuint loadShaders(const char *vertex_fn, const char *fragment_fn) {
+    // Compile the shaders
+    GLuint vertexShaderID = loadShader(vertex_fn, GL_VERTEX_SHADER),
+           fragmentShaderID = loadShader(fragment_fn, GL_FRAGMENT_SHADER);
+
+    puts("Linking shader program...");
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    glLinkProgram(programID);
+
+    // Check the program
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0) {
+        char *log = (char*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetProgramInfoLog(programID, logLength, NULL, log);
+        printf("Shader link message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    return programID;
+}
+
+static void vertexAttribs() {
+    // Our vertices. Three consecutive floats give a 3D vertex; Three
+    // consecutive vertices give a triangle.
+    // A cube has 6 faces with 2 triangles each, so this makes 6*2=12 triangles,
+    // and 12*3 vertices
+    static const GLfloat vertexData[] = {
+        -1.0f,-1.0f,-1.0f,
+        -1.0f,-1.0f, 1.0f,
+        -1.0f, 1.0f, 1.0f,
+         1.0f, 1.0f,-1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f, 1.0f,
+        -1.0f,-1.0f,-1.0f,
+         1.0f,-1.0f,-1.0f,
+         1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f,-1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f, 1.0f,
+        -1.0f,-1.0f, 1.0f,
+        -1.0f,-1.0f,-1.0f,
+        -1.0f, 1.0f, 1.0f,
+        -1.0f,-1.0f, 1.0f,
+         1.0f,-1.0f, 1.0f,
+         1.0f, 1.0f, 1.0f,
+         1.0f,-1.0f,-1.0f,
+         1.0f, 1.0f,-1.0f,
+         1.0f,-1.0f,-1.0f,
+         1.0f, 1.0f, 1.0f,
+         1.0f,-1.0f, 1.0f,
+         1.0f, 1.0f, 1.0f,
+         1.0f, 1.0f,-1.0f,
+        -1.0f, 1.0f,-1.0f,
+         1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f,-1.0f,
+        -1.0f, 1.0f, 1.0f,
+         1.0f, 1.0f, 1.0f,
+        -1.0f, 1.0f, 1.0f,
+         1.0f,-1.0f, 1.0f
+    };
+    // Make the VBO and add it to the VAO.
+    GLuint vertexVBOID;
+    glGenBuffers(1, &vertexVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexVBOID);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vertexData), vertexData,
+        GL_STATIC_DRAW);
+    // 1st attribute buffer: vertices
+    const GLuint vertexVAAID = 0;
+    glEnableVertexAttribArray(vertexVAAID);
+    glVertexAttribPointer(
+        vertexVAAID,  // attribute. No particular reason for 0, but must match
+                      // the layout in the shader.
+        3,            // size
+        GL_FLOAT,     // type
+        GL_FALSE,     // normalized?
+        0,            // stride
+        NULL          // array buffer offset
+    );
+}
+
+static void colourAttribs() {
+    // One color for each vertex. They were generated randomly.
+    static const GLfloat colourData[] = {
+        0.583f,  0.771f,  0.014f,
+        0.609f,  0.115f,  0.436f,
+        0.327f,  0.483f,  0.844f,
+        0.822f,  0.569f,  0.201f,
+        0.435f,  0.602f,  0.223f,
+        0.310f,  0.747f,  0.185f,
+        0.597f,  0.770f,  0.761f,
+        0.559f,  0.436f,  0.730f,
+        0.359f,  0.583f,  0.152f,
+        0.483f,  0.596f,  0.789f,
+        0.559f,  0.861f,  0.639f,
+        0.195f,  0.548f,  0.859f,
+        0.014f,  0.184f,  0.576f,
+        0.771f,  0.328f,  0.970f,
+        0.406f,  0.615f,  0.116f,
+        0.676f,  0.977f,  0.133f,
+        0.971f,  0.572f,  0.833f,
+        0.140f,  0.616f,  0.489f,
+        0.997f,  0.513f,  0.064f,
+        0.945f,  0.719f,  0.592f,
+        0.543f,  0.021f,  0.978f,
+        0.279f,  0.317f,  0.505f,
+        0.167f,  0.620f,  0.077f,
+        0.347f,  0.857f,  0.137f,
+        0.055f,  0.953f,  0.042f,
+        0.714f,  0.505f,  0.345f,
+        0.783f,  0.290f,  0.734f,
+        0.722f,  0.645f,  0.174f,
+        0.302f,  0.455f,  0.848f,
+        0.225f,  0.587f,  0.040f,
+        0.517f,  0.713f,  0.338f,
+        0.053f,  0.959f,  0.120f,
+        0.393f,  0.621f,  0.362f,
+        0.673f,  0.211f,  0.457f,
+        0.820f,  0.883f,  0.371f,
+        0.982f,  0.099f,  0.879f
+    };
+    GLuint colourVBOID;
+    glGenBuffers(1, &colourVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, colourVBOID);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(colourData), colourData,
+        GL_STATIC_DRAW);
+    // 2nd attribute buffer: colors
+    const GLuint colourVAAID = 1;
+    glEnableVertexAttribArray(colourVAAID);
+    glVertexAttribPointer(
+        colourVAAID,  // attribute. No particular reason for 1, but must match
+                      // the layout in the shader.
+        3,            // size
+        GL_FLOAT,     // type
+        GL_FALSE,     // normalized?
+        0,            // stride
+        NULL          // array buffer offset
+    );
+}
+
+// A node in the scene graph. Each one orbits and spins around its parent; the
+// leaves are cubes.
+struct SceneNode {
+    SceneNode *parent = NULL, *firstChild = NULL, *nextSibling = NULL;
+
+    float orbitRadius, orbitHeight, orbitSpeed, orbitPhase, spinSpeed;
+    // Size of the cube drawn here, or 0 for nodes that only group others
+    float cubeScale;
+
+    // Placement in the world as of the last frame
+    glm::mat4 world;
+
+    SceneNode(float orbitRadius, float orbitHeight, float orbitSpeed,
+              float orbitPhase, float spinSpeed, float cubeScale):
+        orbitRadius(orbitRadius), orbitHeight(orbitHeight),
+        orbitSpeed(orbitSpeed), orbitPhase(orbitPhase), spinSpeed(spinSpeed),
+        cubeScale(cubeScale) {}
+
+    void addChild(SceneNode *child) {
+        child->parent = this;
+        child->nextSibling = firstChild;
+        firstChild = child;
+    }
+};
+
+// A grid of clusters, each a swarm of cubes: far more than 08 draws, so that
+// walking the scene and building the draws is real work to spread around.
+static const int clusterGrid = 16, clusterCount = clusterGrid * clusterGrid,
+                 cubesPerCluster = 256,
+                 cubeCount = clusterCount * cubesPerCluster;
+static const float clusterSpacing = 30;
+// Big enough to hold every cube in a cluster, wherever they orbit to
+static const float clusterRadius = 14;
+// The most threads that can record at once
+static const int maxWorkers = 16;
+// Bind program, bind vertex array, update, bind instances and draw
+static const int commandsPerCluster = 5;
+
+// The top byte of every sort key: all of one pass runs before the next
+enum Pass {
+    PASS_VIEW,
+    PASS_OPAQUE,
+};
+
+// Render thread time, split into where it went
+struct RecordStats {
+    unsigned frames;
+    double recordSeconds, mergeSeconds, executeSeconds;
+    size_t groups, glCalls, redundantBinds, cubesDrawn;
+};
+
+static struct {
+    Pool<SceneNode> *nodes;
+    SceneNode *clusters[clusterCount];
+
+    GLuint vaoID, instanceVBOID, programID;
+    GLint vpID;
+
+    // One per recording thread. When no workers are in use, the render
+    // thread records into the first.
+    CommandBuffer *buffers[maxWorkers];
+    // The render thread's own commands, which set up the view
+    CommandBuffer *view;
+    FrameArena *mergeArena;
+
+    // Threads recording now, and the most there can be
+    int workerCount, workerLimit;
+
+    // Indexed by worker count; window is since the last report
+    RecordStats stats[maxWorkers + 1], window;
+} scene;
+
+// The recording threads, and the frame they're working on
+static struct {
+    std::thread threads[maxWorkers];
+    std::mutex mutex;
+    std::condition_variable start, done;
+    unsigned generation;
+    int active, pending;
+    bool quit;
+
+    // Set by the render thread, under the mutex, before each frame starts
+    float time;
+    glm::mat4 vp;
+    glm::vec3 eye;
+} workers;
+
+static void buildScene() {
+    scene.nodes = new Pool<SceneNode>(clusterCount * (1 + cubesPerCluster));
+
+    // A fixed seed, so every run draws the same scene
+    srand(9);
+    const float pi = 3.14159265f;
+    for (int c = 0; c < clusterCount; c++) {
+        // Clusters stay put on the grid and spin; their cubes orbit them
+        float x = (c % clusterGrid - (clusterGrid - 1) / 2.f) * clusterSpacing,
+              z = (c / clusterGrid - (clusterGrid - 1) / 2.f) * clusterSpacing;
+        SceneNode *cluster = scene.nodes->create(
+            sqrtf(x*x + z*z), 0, 0, atan2f(z, x), 0.3f, 0);
+        scene.clusters[c] = cluster;
+        for (int i = 0; i < cubesPerCluster; i++) {
+            float r = rand() / (float)RAND_MAX;
+            SceneNode *cube = scene.nodes->create(
+                3 + 9*r, 6 * (rand() / (float)RAND_MAX - 0.5f),
+                0.2f + 0.8f * (1 - r), 2*pi * rand() / RAND_MAX,
+                2 * rand() / (float)RAND_MAX, 0.15f + 0.2f * (1 - r));
+            cluster->addChild(cube);
+        }
+    }
+}
+
+static void instanceAttribs() {
+    glGenBuffers(1, &scene.instanceVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.instanceVBOID);
+    glBufferData(GL_ARRAY_BUFFER, cubeCount * sizeof(glm::mat4), NULL,
+        GL_STREAM_DRAW);
+    // 3rd-6th attribute buffers: the columns of each cube's model matrix,
+    // advancing once per instance. Where they point is set before each draw.
+    for (GLuint column = 0; column < 4; column++) {
+        const GLuint modelVAAID = 2 + column;
+        glEnableVertexAttribArray(modelVAAID);
+        glVertexAttribDivisor(modelVAAID, 1);
+    }
+}
+
+static void printWorkers() {
+    if (scene.workerCount)
+        printf("Recording on %d worker thread(s)\n", scene.workerCount);
+    else
+        puts("Recording on the render thread");
+}
+
+static void keyCallback(GLFWwindow *window, int key, int scancode,
+                        int action, int mods) {
+    if (action != GLFW_PRESS || key < GLFW_KEY_0 || key > GLFW_KEY_9)
+        return;
+    int count = key - GLFW_KEY_0;
+    scene.workerCount = count < scene.workerLimit ? count : scene.workerLimit;
+    printWorkers();
+}
+
+static void workerMain(int index);
+
+static void startWorkers() {
+    unsigned cores = std::thread::hardware_concurrency();
+    scene.workerLimit = cores < 1 ? 1 : cores > maxWorkers ? maxWorkers : cores;
+    for (int i = 0; i < scene.workerLimit; i++) {
+        // Every buffer could end up with every cluster
+        scene.buffers[i] = new CommandBuffer(
+            clusterCount * commandsPerCluster, clusterCount,
+            cubeCount * sizeof(glm::mat4) + clusterCount * 64);
+        workers.threads[i] = std::thread(workerMain, i);
+    }
+    scene.view = new CommandBuffer(4, 1, 4096);
+    scene.mergeArena = new FrameArena((clusterCount + 1) * sizeof(CommandRun)
+        + 4096);
+    scene.workerCount = scene.workerLimit;
+}
+
+static void stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(workers.mutex);
+        workers.quit = true;
+    }
+    workers.start.notify_all();
+    for (int i = 0; i < scene.workerLimit; i++)
+        workers.threads[i].join();
+}
+
+static void init(GLFWwindow **window) {
+    // Set error callback to see more detailed failure info
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    glfwWindowHint(GLFW_SAMPLES, 4); // 4x antialiasing
+
+    // To ensure compatiblity, check the output of this command:
+    // $ glxinfo | grep 'Max core profile version'
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+    // To make MacOS happy
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // We don't want the old OpenGL
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Open a window and create its OpenGL context
+    *window = glfwCreateWindow(1024, 768,
+        "Tutorial 09 - Command buffers", NULL, NULL);
+    if (!*window) {
+        fputs("Failed to open GLFW window.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(*window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(*window, GLFW_STICKY_KEYS, GL_TRUE);
+    glfwSetKeyCallback(*window, keyCallback);
+    // Don't wait for vsync, so frame times mean something
+    glfwSwapInterval(0);
+
+    // Dark blue background
+    glClearColor(0.0, 0.0, 0.4, 0.0);
+
+    // Enable depth test
+    glEnable(GL_DEPTH_TEST);
+    // Accept fragment if it's closer to the camera than the former one
+    glDepthFunc(GL_LESS);
+
+    buildScene();
+
+    // Make the VAO.
+    glGenVertexArrays(1, &scene.vaoID);
+    glBindVertexArray(scene.vaoID);
+    vertexAttribs();
+    colourAttribs();
+    instanceAttribs();
+    // The VAO is ready.
+
+    // Create and compile our GLSL program from the shaders
+    scene.programID = loadShaders("node-vertex.glsl", "color-fragment.glsl");
+    scene.vpID = glGetUniformLocation(scene.programID, "VP");
+
+    startWorkers();
+
+    puts("Initialized.");
+}
+
+// The six planes of the view frustum, each as (normal, distance) with the
+// normal pointing inwards, taken straight from the view-projection matrix.
+static void frustumPlanes(const glm::mat4 &vp, glm::vec4 planes[6]) {
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; r++)
+        rows[r] = glm::vec4(vp[0][r], vp[1][r], vp[2][r], vp[3][r]);
+    for (int axis = 0; axis < 3; axis++) {
+        planes[axis*2]     = rows[3] + rows[axis];
+        planes[axis*2 + 1] = rows[3] - rows[axis];
+    }
+    for (int p = 0; p < 6; p++)
+        planes[p] /= glm::length(glm::vec3(planes[p].x, planes[p].y,
+            planes[p].z));
+}
+
+static bool sphereVisible(const glm::vec4 planes[6], glm::vec3 centre,
+                          float radius) {
+    for (int p = 0; p < 6; p++)
+        if (glm::dot(glm::vec3(planes[p].x, planes[p].y, planes[p].z), centre)
+            + planes[p].w < -radius)
+            return false;
+    return true;
+}
+
+static void place(SceneNode *node, float time) {
+    float orbit = node->orbitPhase + time * node->orbitSpeed;
+    glm::mat4 local = glm::translate(glm::mat4(1), glm::vec3(
+        node->orbitRadius * cosf(orbit), node->orbitHeight,
+        node->orbitRadius * sinf(orbit)));
+    local = glm::rotate(local, time * node->spinSpeed, glm::vec3(0, 1, 0));
+    node->world = node->parent ? node->parent->world * local : local;
+}
+
+// Groups sort by pass, then front to back, so nearer cubes fill the depth
+// buffer first. Distances are positive, so their bit patterns sort the same
+// way as their values.
+static uint64_t sortKey(Pass pass, float distance) {
+    uint32_t bits;
+    memcpy(&bits, &distance, sizeof(bits));
+    return (uint64_t)pass << 56 | bits;
+}
+
+// Place part of parts of the clusters, and record a draw of the visible cubes
+// in each. Only touches the clusters it's given and its own buffer, so any
+// number of threads can run this at once.
+static void recordClusters(CommandBuffer &buffer, int part, int parts) {
+    buffer.reset();
+
+    glm::vec4 planes[6];
+    frustumPlanes(workers.vp, planes);
+
+    int first = clusterCount * part / parts,
+        end = clusterCount * (part + 1) / parts;
+    for (int c = first; c < end; c++) {
+        SceneNode *cluster = scene.clusters[c];
+        place(cluster, workers.time);
+        glm::vec3 centre(cluster->world[3].x, cluster->world[3].y,
+            cluster->world[3].z);
+        if (!sphereVisible(planes, centre, clusterRadius))
+            continue;
+
+        glm::mat4 *instances = buffer.allocate<glm::mat4>(cubesPerCluster);
+        uint32_t visible = 0;
+        for (SceneNode *cube = cluster->firstChild; cube;
+             cube = cube->nextSibling) {
+            place(cube, workers.time);
+            // The cube spans -1 to 1 before scaling, so sqrt(3) covers it
+            if (sphereVisible(planes, glm::vec3(cube->world[3].x,
+                    cube->world[3].y, cube->world[3].z),
+                    cube->cubeScale * 1.7321f))
+                instances[visible++] = glm::scale(cube->world,
+                    glm::vec3(cube->cubeScale));
+        }
+        if (!visible)
+            continue;
+
+        // Each cluster has its own stretch of the instance buffer, so
+        // threads don't need to agree on where their data goes
+        uint32_t offset = c * cubesPerCluster * sizeof(glm::mat4);
+        buffer.begin(sortKey(PASS_OPAQUE, glm::length(centre - workers.eye)));
+        buffer.bindProgram(scene.programID);
+        buffer.bindVertexArray(scene.vaoID);
+        buffer.updateBuffer(scene.instanceVBOID, offset,
+            visible * sizeof(glm::mat4), instances);
+        buffer.bindInstances(scene.instanceVBOID, offset);
+        // 12*3 vertices per cube, once for every visible cube
+        buffer.draw(0, 12*3, visible);
+    }
+}
+
+static void workerMain(int index) {
+    unsigned seen = 0;
+    for (;;) {
+        int active;
+        {
+            std::unique_lock<std::mutex> lock(workers.mutex);
+            workers.start.wait(lock, [&] {
+                return workers.quit || workers.generation != seen;
+            });
+            if (workers.quit)
+                return;
+            seen = workers.generation;
+            active = workers.active;
+        }
+        // Threads beyond the number in use sit this frame out
+        if (index >= active)
+            continue;
+
+        recordClusters(*scene.buffers[index], index, active);
+
+        std::lock_guard<std::mutex> lock(workers.mutex);
+        if (!--workers.pending)
+            workers.done.notify_one();
+    }
+}
+
+// Record every cluster, on the workers if there are any, and return how many
+// buffers were filled.
+static int recordScene(float time, const glm::mat4 &vp, glm::vec3 eye) {
+    std::unique_lock<std::mutex> lock(workers.mutex);
+    workers.time = time;
+    workers.vp = vp;
+    workers.eye = eye;
+
+    if (!scene.workerCount) {
+        lock.unlock();
+        recordClusters(*scene.buffers[0], 0, 1);
+        return 1;
+    }
+
+    workers.active = workers.pending = scene.workerCount;
+    workers.generation++;
+    workers.start.notify_all();
+    workers.done.wait(lock, [] { return !workers.pending; });
+    return workers.active;
+}
+
+// The GL backend: run the merged commands. Bindings are tracked, so that a
+// group binding what the last one left bound costs nothing; most do.
+static void execute(const FrameVector<CommandRun> &runs, RecordStats &stats) {
+    GLuint program = 0, vertexArray = 0, arrayBuffer = 0;
+
+    for (const CommandRun &run: runs) {
+        for (const Command *c = run.commands; c < run.commands + run.count;
+             c++) {
+            switch (c->type) {
+            case CMD_BIND_PROGRAM:
+                if (c->bindProgram.program == program) {
+                    stats.redundantBinds++;
+                    break;
+                }
+                program = c->bindProgram.program;
+                glUseProgram(program);
+                stats.glCalls++;
+                break;
+            case CMD_BIND_VERTEX_ARRAY:
+                if (c->bindVertexArray.vertexArray == vertexArray) {
+                    stats.redundantBinds++;
+                    break;
+                }
+                vertexArray = c->bindVertexArray.vertexArray;
+                glBindVertexArray(vertexArray);
+                stats.glCalls++;
+                break;
+            case CMD_BIND_INSTANCES:
+                if (c->bindInstances.buffer != arrayBuffer) {
+                    arrayBuffer = c->bindInstances.buffer;
+                    glBindBuffer(GL_ARRAY_BUFFER, arrayBuffer);
+                    stats.glCalls++;
+                }
+                // GL 3.3 can't start an instanced draw part way through the
+                // instances, so point the per-instance attributes there
+                for (GLuint column = 0; column < 4; column++)
+                    glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE,
+                        sizeof(glm::mat4), (const void*)(uintptr_t)
+                        (c->bindInstances.offset + column*sizeof(glm::vec4)));
+                stats.glCalls += 4;
+                break;
+            case CMD_SET_MATRIX:
+                glUniformMatrix4fv(c->setMatrix.uniform, 1, GL_FALSE,
+                    c->setMatrix.value);
+                stats.glCalls++;
+                break;
+            case CMD_UPDATE_BUFFER:
+                if (c->updateBuffer.buffer != arrayBuffer) {
+                    arrayBuffer = c->updateBuffer.buffer;
+                    glBindBuffer(GL_ARRAY_BUFFER, arrayBuffer);
+                    stats.glCalls++;
+                }
+                glBufferSubData(GL_ARRAY_BUFFER, c->updateBuffer.offset,
+                    c->updateBuffer.size, c->updateBuffer.data);
+                stats.glCalls++;
+                break;
+            case CMD_DRAW:
+                glDrawArraysInstanced(GL_TRIANGLES, c->draw.first,
+                    c->draw.count, c->draw.instanceCount);
+                stats.glCalls++;
+                stats.cubesDrawn += c->draw.instanceCount;
+                break;
+            }
+        }
+    }
+}
+
+static void addStats(RecordStats &to, const RecordStats &from) {
+    to.frames += from.frames;
+    to.recordSeconds += from.recordSeconds;
+    to.mergeSeconds += from.mergeSeconds;
+    to.executeSeconds += from.executeSeconds;
+    to.groups += from.groups;
+    to.glCalls += from.glCalls;
+    to.redundantBinds += from.redundantBinds;
+    to.cubesDrawn += from.cubesDrawn;
+}
+
+// Everything the render thread does for a frame, short of swapping buffers
+static RecordStats drawFrame(float time) {
+    RecordStats stats = {};
+    stats.frames = 1;
+
+    glm::mat4 projection = glm::perspective(
+        glm::radians(45.f), 4.f/3, 0.1f, 700.f);
+    glm::vec3 eye(0, 120, 300);
+    glm::mat4 view = glm::lookAt(
+        eye,                   // High above one edge of the grid,
+        glm::vec3(0, 0, -40),  // looking across it
+        glm::vec3(0, 1, 0)
+    );
+    glm::mat4 vp = projection * view;
+
+    double start = glfwGetTime();
+
+    // The camera goes first, whoever records the rest
+    scene.view->reset();
+    scene.view->begin(sortKey(PASS_VIEW, 0));
+    scene.view->bindProgram(scene.programID);
+    scene.view->setMatrix(scene.vpID, &vp[0][0]);
+    int recorded = recordScene(time, vp, eye);
+    double afterRecord = glfwGetTime();
+
+    CommandBuffer *buffers[maxWorkers + 1] = {scene.view};
+    for (int i = 0; i < recorded; i++)
+        buffers[1 + i] = scene.buffers[i];
+    scene.mergeArena->reset();
+    FrameVector<CommandRun> runs(scene.mergeArena);
+    runs.reserve(clusterCount + 1);
+    mergeCommandBuffers(buffers, recorded + 1, runs);
+    stats.groups = runs.size();
+    double afterMerge = glfwGetTime();
+
+    // Orphan last frame's instance data rather than waiting for the GPU to
+    // finish with it; this frame's goes in as each cluster is drawn
+    glBindBuffer(GL_ARRAY_BUFFER, scene.instanceVBOID);
+    glBufferData(GL_ARRAY_BUFFER, cubeCount * sizeof(glm::mat4), NULL,
+        GL_STREAM_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // Clear the screen
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    execute(runs, stats);
+    double afterExecute = glfwGetTime();
+
+    stats.recordSeconds = afterRecord - start;
+    stats.mergeSeconds = afterMerge - afterRecord;
+    stats.executeSeconds = afterExecute - afterMerge;
+    return stats;
+}
+
+static void printRow(const char *label, const RecordStats &stats) {
+    if (!stats.frames)
+        return;
+    double n = stats.frames;
+    printf("%-14s %7.3f %7.3f %8.3f %13.3f %8.0f %8.0f\n", label,
+        stats.recordSeconds * 1e3 / n, stats.mergeSeconds * 1e3 / n,
+        stats.executeSeconds * 1e3 / n,
+        (stats.recordSeconds + stats.mergeSeconds + stats.executeSeconds)
+        * 1e3 / n, stats.glCalls / n, stats.cubesDrawn / n);
+}
+
+static void printHeader() {
+    printf("%-14s %7s %7s %8s %13s %8s %8s\n", "recording on", "record",
+        "merge", "execute", "render thread", "GL calls", "cubes");
+}
+
+static void printStats() {
+    puts("\nAverage ms per frame:");
+    printHeader();
+    for (int n = 0; n <= scene.workerLimit; n++) {
+        char label[32];
+        if (n)
+            snprintf(label, sizeof(label), "%d worker(s)", n);
+        else
+            snprintf(label, sizeof(label), "render thread");
+        printRow(label, scene.stats[n]);
+    }
+}
+
+int main(int argc, char **argv) {
+    markMainStart();
+
+    bool bench = argc == 2 && !strcmp(argv[1], "bench");
+    if (argc > 1 && !bench) {
+        fputs("Usage: 09 [bench]\n"
+              "  bench draws a fixed number of frames with the render thread\n"
+              "  recording, then with 1, 2, 4... worker threads, then exits.\n"
+              "  Otherwise, keys 0-9 pick how many workers record.\n",
+              stderr);
+        return 1;
+    }
+
+    GLFWwindow *window;
+    init(&window);
+
+    // In bench mode, every worker count sees the same camera path, and the
+    // first few frames after a switch aren't counted.
+    const unsigned benchFrames = 200, warmupFrames = 20;
+    unsigned configFrame = 0;
+    if (bench)
+        scene.workerCount = 0;
+    printWorkers();
+    int lastCount = scene.workerCount;
+    double lastReport = glfwGetTime();
+
+    do {
+        RecordStats stats = drawFrame(bench ? configFrame * 0.01f
+                                            : glfwGetTime());
+
+        // Swap buffers
+        glfwSwapBuffers(window);
+        reportStartupTime();
+        glfwPollEvents();
+
+        if (!bench || configFrame >= warmupFrames) {
+            addStats(scene.stats[lastCount], stats);
+            addStats(scene.window, stats);
+        }
+        configFrame++;
+        if (scene.workerCount != lastCount) {
+            lastCount = scene.workerCount;
+            configFrame = 0;
+        }
+
+        if (bench && configFrame == warmupFrames + benchFrames) {
+            if (lastCount == scene.workerLimit)
+                break;
+            // Double up, but always finish with every worker
+            int next = lastCount ? lastCount * 2 : 1;
+            scene.workerCount = lastCount = next < scene.workerLimit
+                                          ? next : scene.workerLimit;
+            configFrame = 0;
+            printWorkers();
+        }
+
+        double now = glfwGetTime();
+        if (!bench && now - lastReport >= 1) {
+            printHeader();
+            printRow("last second", scene.window);
+            scene.window = {};
+            lastReport = now;
+        }
+
+        // Check if the ESC key was pressed or the window was closed
+    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+             !glfwWindowShouldClose(window));
+
+    stopWorkers();
+    printStats();
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}
@@ -0,0 +1,492 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "../common/gltrace.h"
+#include "../common/geometry-store.hpp"
+#include "../common/startup-time.h"
+#include "shaders.h"
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+static GLuint loadShader(const char *fn, GLenum shaderType) {
+    printf("Compiling shader '%s'...\n", fn);
+
+    GLuint shaderID = glCreateShader(shaderType);
+    if (!shaderID) {
+        fprintf(stderr, "Failed to create shader\n");
+        exit(1);
+    }
+
+    // Embedded at build time, unless SHADER_DIR says to read it from disk
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    glShaderSource(shaderID, 1, &source, &size);
+    free(allocated);
+
+    glCompileShader(shaderID);
+
+    GLint logLength;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength) {
+        GLchar *log = (GLchar*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetShaderInfoLog(shaderID, logLength, NULL, log);
+        printf("Shader compile message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    return shaderID;
+}
+
+static GLuint loadShaders(const char *vertex_fn, const char *fragment_fn) {
+    // Compile the shaders
+    GLuint vertexShaderID = loadShader(vertex_fn, GL_VERTEX_SHADER),
+           fragmentShaderID = loadShader(fragment_fn, GL_FRAGMENT_SHADER);
+
+    puts("Linking shader program...");
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    glLinkProgram(programID);
+
+    // Check the program
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0) {
+        char *log = (char*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetProgramInfoLog(programID, logLength, NULL, log);
+        printf("Shader link message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    return programID;
+}
+
+struct Vertex {
+    glm::vec2 position;
+    GLubyte colour[4]; // The 4th is padding
+};
+
+// A line feature on the map, such as a road or a contour: a wiggly polyline
+// drawn as a quad per segment. Its shape comes from its seed and phase, so
+// editing it only needs those to change.
+struct Feature {
+    size_t offset; // Where its vertices are in the store
+    uint32_t points;
+    uint32_t seed;
+    float phase;
+    glm::vec2 start;
+    GLubyte colour[3];
+};
+
+static const int sceneWidth = 1024, sceneHeight = 768;
+static const int featureCount = 65536;
+static const uint32_t minPoints = 2, maxPoints = 16;
+static const float halfWidth = 0.6f;
+
+// Each segment is two triangles
+static size_t featureBytes(uint32_t points) {
+    return (points - 1) * 6 * sizeof(Vertex);
+}
+
+struct UploadTotals {
+    unsigned frames;
+    double uploadSeconds, frameSeconds;
+    size_t bytesChanged, bytes, calls, rangesMarked, rangesUploaded;
+};
+
+static const int editSteps[] = {1, 16, 256, 4096};
+static const int editStepCount = sizeof(editSteps) / sizeof(editSteps[0]);
+
+static struct {
+    GeometryStore *store;
+    std::vector<Feature> features;
+    std::mt19937 rng;
+
+    UploadMode mode;
+    int editsPerFrame;
+
+    GLuint programID;
+    GLint viewportID;
+
+    // By mode and by step in editSteps, for the bench; window is since the
+    // last report
+    UploadTotals totals[UPLOAD_MODE_COUNT][editStepCount], window;
+} scene;
+
+// Write a feature's triangles straight into the store's copy of the buffer
+static void writeFeature(const Feature &f) {
+    Vertex *v = (Vertex*)scene.store->data(f.offset);
+    // A cheap hash of the seed picks the overall direction
+    float heading = (f.seed * 2654435761u >> 8) / 16777216.f * 6.2831853f;
+
+    glm::vec2 a = f.start;
+    for (uint32_t i = 1; i < f.points; i++) {
+        float turn = heading + 0.8f * sinf(f.phase + i * 1.7f + f.seed);
+        glm::vec2 b = a + 6.f * glm::vec2(cosf(turn), sinf(turn));
+
+        glm::vec2 along = glm::normalize(b - a);
+        glm::vec2 n = glm::vec2(-along.y, along.x) * halfWidth;
+        const glm::vec2 corners[6] = {a - n, a + n, b + n, a - n, b + n, b - n};
+        for (const glm::vec2 &corner: corners) {
+            v->position = corner;
+            memcpy(v->colour, f.colour, 3);
+            v->colour[3] = 0;
+            v++;
+        }
+        a = b;
+    }
+    scene.store->markDirty(f.offset, featureBytes(f.points));
+}
+
+static void buildMap() {
+    // Room for every feature at its largest, so the bench doesn't start by
+    // growing; shrinking features leave holes to be reused.
+    scene.store = new GeometryStore(GL_ARRAY_BUFFER,
+        featureCount * featureBytes(maxPoints));
+    scene.features.resize(featureCount);
+
+    // A fixed seed, so every run edits the same features the same way
+    scene.rng.seed(10);
+    std::uniform_int_distribution<uint32_t> points(minPoints, maxPoints);
+    std::uniform_real_distribution<float> x(0, sceneWidth), y(0, sceneHeight);
+    for (Feature &f: scene.features) {
+        f.points = points(scene.rng);
+        f.seed = scene.rng();
+        f.phase = 0;
+        f.start = glm::vec2(x(scene.rng), y(scene.rng));
+        for (int c = 0; c < 3; c++)
+            f.colour[c] = 64 + scene.rng() % 192;
+        f.offset = scene.store->allocate(featureBytes(f.points));
+        writeFeature(f);
+    }
+}
+
+// What an editing session does: reshape some features where they are, and
+// make others longer or shorter, which moves them to a new range.
+static size_t editFeatures(int edits) {
+    size_t bytesChanged = 0;
+    std::uniform_int_distribution<uint32_t> points(minPoints, maxPoints);
+    for (int e = 0; e < edits; e++) {
+        Feature &f = scene.features[scene.rng() % featureCount];
+        f.phase += 0.5f;
+        uint32_t newPoints = scene.rng() & 1 ? f.points : points(scene.rng);
+        if (newPoints != f.points) {
+            // Blank the old triangles so they stop drawing, then free them
+            size_t oldBytes = featureBytes(f.points);
+            scene.store->clear(f.offset, oldBytes);
+            scene.store->release(f.offset, oldBytes);
+            bytesChanged += oldBytes;
+            f.points = newPoints;
+            f.offset = scene.store->allocate(featureBytes(f.points));
+        }
+        writeFeature(f);
+        bytesChanged += featureBytes(f.points);
+    }
+    return bytesChanged;
+}
+
+static void vertexAttribs() {
+    glBindBuffer(GL_ARRAY_BUFFER, scene.store->buffer());
+    // 1st attribute buffer: positions
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex),
+        (const void*)offsetof(Vertex, position));
+    // 2nd attribute buffer: colours, as bytes scaled to 0-1
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(Vertex),
+        (const void*)offsetof(Vertex, colour));
+}
+
+// Which of the bench's totals the current mode and edit count go in, or -1 if
+// the count isn't one of editSteps; then only the report window counts them.
+static int currentConfig() {
+    for (int step = 0; step < editStepCount; step++)
+        if (editSteps[step] == scene.editsPerFrame)
+            return scene.mode * editStepCount + step;
+    return -1;
+}
+
+static void printConfig() {
+    printf("Uploading by %s, %d edit(s) per frame\n",
+        uploadModeNames[scene.mode], scene.editsPerFrame);
+}
+
+static void keyCallback(GLFWwindow *window, int key, int scancode,
+                        int action, int mods) {
+    if (action != GLFW_PRESS)
+        return;
+    switch (key) {
+    case GLFW_KEY_U:
+        scene.mode = (UploadMode)((scene.mode + 1) % UPLOAD_MODE_COUNT);
+        break;
+    case GLFW_KEY_EQUAL:
+        if (scene.editsPerFrame < featureCount)
+            scene.editsPerFrame *= 2;
+        break;
+    case GLFW_KEY_MINUS:
+        if (scene.editsPerFrame > 1)
+            scene.editsPerFrame /= 2;
+        break;
+    default:
+        return;
+    }
+    printConfig();
+}
+
+static void init(GLFWwindow **window) {
+    // Set error callback to see more detailed failure info
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    // To ensure compatiblity, check the output of this command:
+    // $ glxinfo | grep 'Max core profile version'
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+    // To make MacOS happy
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // We don't want the old OpenGL
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Open a window and create its OpenGL context
+    *window = glfwCreateWindow(sceneWidth, sceneHeight,
+        "Tutorial 10 - Geometry updates", NULL, NULL);
+    if (!*window) {
+        fputs("Failed to open GLFW window.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(*window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(*window, GLFW_STICKY_KEYS, GL_TRUE);
+    glfwSetKeyCallback(*window, keyCallback);
+    // Don't wait for vsync, so frame times mean something
+    glfwSwapInterval(0);
+
+    // Dark blue background
+    glClearColor(0.0, 0.0, 0.4, 0.0);
+
+    // Make the VAO.
+    GLuint vaoID;
+    glGenVertexArrays(1, &vaoID);
+    glBindVertexArray(vaoID);
+    buildMap();
+    vertexAttribs();
+    // The VAO is ready.
+
+    // Create and compile our GLSL program from the shaders
+    scene.programID = loadShaders("map-vertex.glsl", "solid-fragment.glsl");
+    glUseProgram(scene.programID);
+    scene.viewportID = glGetUniformLocation(scene.programID, "viewport");
+    glUniform2f(scene.viewportID, sceneWidth, sceneHeight);
+
+    puts("Initialized.");
+}
+
+static UploadTotals drawFrame() {
+    UploadTotals totals = {};
+    totals.frames = 1;
+    totals.bytesChanged = editFeatures(scene.editsPerFrame);
+
+    double start = glfwGetTime();
+    UploadStats stats = scene.store->upload(scene.mode);
+    totals.uploadSeconds = glfwGetTime() - start;
+    totals.bytes = stats.bytes;
+    totals.calls = stats.calls;
+    totals.rangesMarked = stats.rangesMarked;
+    totals.rangesUploaded = stats.rangesUploaded;
+
+    // Clear the screen
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    // Everything up to the last feature; holes are blank, so draw nothing
+    glDrawArrays(GL_TRIANGLES, 0, scene.store->bytesInUse() / sizeof(Vertex));
+
+    return totals;
+}
+
+static void addTotals(UploadTotals &to, const UploadTotals &from) {
+    to.frames += from.frames;
+    to.uploadSeconds += from.uploadSeconds;
+    to.frameSeconds += from.frameSeconds;
+    to.bytesChanged += from.bytesChanged;
+    to.bytes += from.bytes;
+    to.calls += from.calls;
+    to.rangesMarked += from.rangesMarked;
+    to.rangesUploaded += from.rangesUploaded;
+}
+
+static void printHeader() {
+    printf("%-12s %6s %12s %12s %12s %10s %10s %9s\n", "upload", "edits",
+        "changed KiB", "sent KiB", "ranges", "calls", "upload ms",
+        "frame ms");
+}
+
+static void printRow(UploadMode mode, int edits, const UploadTotals &t) {
+    if (!t.frames)
+        return;
+    double n = t.frames;
+    char ranges[32];
+    snprintf(ranges, sizeof(ranges), "%.0f->%.0f", t.rangesMarked / n,
+        t.rangesUploaded / n);
+    printf("%-12s %6d %12.1f %12.1f %12s %10.1f %10.3f %9.3f\n",
+        uploadModeNames[mode], edits, t.bytesChanged / n / 1024,
+        t.bytes / n / 1024, ranges, t.calls / n, t.uploadSeconds * 1e3 / n,
+        t.frameSeconds * 1e3 / n);
+}
+
+static void printStore() {
+    const RangeAllocator &ranges = scene.store->ranges();
+    printf("Store: %.1f MiB in use of %.1f MiB; %zu hole(s), %.1f MiB free\n",
+        scene.store->bytesInUse() / 1048576.0,
+        ranges.bytesCapacity() / 1048576.0, ranges.holeCount(),
+        ranges.freeBytes() / 1048576.0);
+}
+
+static void printStats() {
+    puts("\nAverage per frame:");
+    printHeader();
+    for (int mode = 0; mode < UPLOAD_MODE_COUNT; mode++)
+        for (int step = 0; step < editStepCount; step++)
+            printRow((UploadMode)mode, editSteps[step],
+                scene.totals[mode][step]);
+    printStore();
+}
+
+int main(int argc, char **argv) {
+    markMainStart();
+
+    bool bench = argc == 2 && !strcmp(argv[1], "bench");
+    if (argc > 1 && !bench) {
+        fputs("Usage: 10 [bench]\n"
+              "  bench draws a fixed number of frames for each upload mode\n"
+              "  and number of edits per frame, then exits.\n"
+              "  Otherwise, U cycles the upload mode and +/- double or halve\n"
+              "  the edits per frame while running.\n",
+              stderr);
+        return 1;
+    }
+
+    scene.mode = UPLOAD_SUB_DATA;
+    scene.editsPerFrame = 16;
+    if (bench) {
+        scene.mode = UPLOAD_WHOLE;
+        scene.editsPerFrame = editSteps[0];
+    }
+
+    GLFWwindow *window;
+    init(&window);
+    printConfig();
+
+    // In bench mode, the first few frames after a switch aren't counted; the
+    // very first uploads the whole map whatever the mode.
+    const unsigned benchFrames = 100, warmupFrames = 10;
+    unsigned configFrame = 0;
+    int config = currentConfig();
+    double lastTime = glfwGetTime(), lastReport = lastTime;
+
+    do {
+        UploadTotals totals = drawFrame();
+
+        // Swap buffers
+        glfwSwapBuffers(window);
+        reportStartupTime();
+        glfwPollEvents();
+
+        double now = glfwGetTime();
+        totals.frameSeconds = now - lastTime;
+        lastTime = now;
+        if (configFrame >= warmupFrames) {
+            if (config >= 0)
+                addTotals(scene.totals[config / editStepCount]
+                                      [config % editStepCount], totals);
+            addTotals(scene.window, totals);
+        }
+        configFrame++;
+        int current = currentConfig();
+        if (current != config) {
+            config = current;
+            configFrame = 0;
+        }
+
+        if (bench && configFrame == warmupFrames + benchFrames) {
+            if (config + 1 == UPLOAD_MODE_COUNT * editStepCount)
+                break;
+            config++;
+            scene.mode = (UploadMode)(config / editStepCount);
+            scene.editsPerFrame = editSteps[config % editStepCount];
+            configFrame = 0;
+            printConfig();
+        }
+
+        if (!bench && now - lastReport >= 1) {
+            printHeader();
+            printRow(scene.mode, scene.editsPerFrame, scene.window);
+            printStore();
+            scene.window = {};
+            lastReport = now;
+        }
+
+        // Check if the ESC key was pressed or the window was closed
+    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+             !glfwWindowShouldClose(window));
+
+    printStats();
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}
@@ -0,0 +1,17 @@
+#version 330 core
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec2 vertexPosition_scenespace;
+layout(location = 1) in vec3 vertexColor;
+
+// Output data; will be interpolated for each fragment.
+out vec3 fragmentColor;
+
+// Size of the scene in pixels.
+uniform vec2 viewport;
+
+void main() {
+    gl_Position = vec4(vertexPosition_scenespace / viewport * 2 - 1, 0, 1);
+
+    fragmentColor = vertexColor;
+}
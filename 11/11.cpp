@@ -0,0 +1,573 @@
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../common/gltrace.h"
+#include "../common/lod.hpp"
+#include "../common/startup-time.h"
+#include "asteroid-lods.h"
+#include "shaders.h"
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+static GLuint loadShader(const char *fn, GLenum shaderType) {
+    printf("Compiling shader '%s'...\n", fn);
+
+    GLuint shaderID = glCreateShader(shaderType);
+    if (!shaderID) {
+        fprintf(stderr, "Failed to create shader\n");
+        exit(1);
+    }
+
+    // Embedded at build time, unless SHADER_DIR says to read it from disk
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    glShaderSource(shaderID, 1, &source, &size);
+    free(allocated);
+
+    glCompileShader(shaderID);
+
+    GLint logLength;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength) {
+        GLchar *log = (GLchar*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetShaderInfoLog(shaderID, logLength, NULL, log);
+        printf("Shader compile message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    return shaderID;
+}
+
+static GLuint loadShaders(const char *vertex_fn, const char *fragment_fn) {
+    // Compile the shaders
+    GLuint vertexShaderID = loadShader(vertex_fn, GL_VERTEX_SHADER),
+           fragmentShaderID = loadShader(fragment_fn, GL_FRAGMENT_SHADER);
+
+    puts("Linking shader program...");
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    glLinkProgram(programID);
+
+    // Check the program
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0) {
+        char *log = (char*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetProgramInfoLog(programID, logLength, NULL, log);
+        printf("Shader link message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    return programID;
+}
+
+// One rock in the belt. Its level of detail is remembered from frame to
+// frame, for hysteresis.
+struct Asteroid {
+    glm::vec3 position, spinAxis;
+    float scale, spinSpeed;
+    int lod;
+};
+
+static const int sceneWidth = 1024, sceneHeight = 768;
+static const float fovY = glm::radians(45.f);
+static const int asteroidCount = 4096;
+// The mesh reaches about 1.3 from its centre, at the top of a lump
+static const float meshRadius = 1.35f;
+static const float defaultHysteresis = 0.25f;
+
+struct LodTotals {
+    unsigned frames;
+    double frameSeconds;
+    size_t visible, triangles, vertices, switches;
+    size_t perLevel[asteroidLodCount];
+};
+
+// What the bench compares: every asteroid at full detail, then levels
+// chosen without and with hysteresis
+static const int configCount = 3;
+static const char *const configNames[configCount] = {
+    "full detail", "LOD", "LOD+hyst"
+};
+
+static struct {
+    std::vector<Asteroid> asteroids;
+    float errors[asteroidLodCount];
+    // Model matrices of the visible asteroids, gathered per level
+    std::vector<glm::mat4> instances[asteroidLodCount];
+
+    bool lodEnabled, tinted;
+    float threshold, hysteresis;
+
+    GLuint instanceVBOID;
+    GLuint programID;
+    GLint vpID, tintID;
+
+    // By config, for the bench; window is since the last report
+    LodTotals totals[configCount], window;
+} scene;
+
+static void buildBelt() {
+    scene.asteroids.resize(asteroidCount);
+    // A fixed seed, so every run draws the same belt
+    srand(11);
+    auto random = [] { return rand() / (float)RAND_MAX; };
+    const float pi = 3.14159265f;
+    for (Asteroid &a: scene.asteroids) {
+        float angle = 2*pi * random(), radius = 40 + 80 * random();
+        a.position = glm::vec3(radius * cosf(angle), 16 * (random() - 0.5f),
+            radius * sinf(angle));
+        a.spinAxis = glm::normalize(glm::vec3(random() - 0.5f, 1,
+            random() - 0.5f));
+        // Mostly small, a few big
+        a.scale = 0.3f + 2.5f * powf(random(), 3);
+        a.spinSpeed = 0.2f + random();
+        a.lod = 0;
+    }
+    for (int level = 0; level < asteroidLodCount; level++) {
+        scene.errors[level] = asteroidLods[level].error;
+        scene.instances[level].reserve(asteroidCount);
+    }
+}
+
+static void vertexAttribs() {
+    // Every level's vertices and indices, one after another; draws pick a
+    // level by where they start in the index buffer
+    GLuint vertexVBOID, indexVBOID;
+    glGenBuffers(1, &vertexVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexVBOID);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(asteroidVertices), asteroidVertices,
+        GL_STATIC_DRAW);
+    glGenBuffers(1, &indexVBOID);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexVBOID);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(asteroidIndices),
+        asteroidIndices, GL_STATIC_DRAW);
+
+    // 1st attribute buffer: positions
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
+        NULL);
+    // 2nd attribute buffer: normals
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(GLfloat),
+        (const void*)(3 * sizeof(GLfloat)));
+}
+
+static void instanceAttribs() {
+    glGenBuffers(1, &scene.instanceVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.instanceVBOID);
+    glBufferData(GL_ARRAY_BUFFER, asteroidCount * sizeof(glm::mat4), NULL,
+        GL_STREAM_DRAW);
+    // 3rd-6th attribute buffers: the columns of each asteroid's model
+    // matrix, advancing once per instance. They're pointed at each level's
+    // instances in turn when drawing.
+    for (GLuint column = 0; column < 4; column++) {
+        const GLuint modelVAAID = 2 + column;
+        glEnableVertexAttribArray(modelVAAID);
+        glVertexAttribDivisor(modelVAAID, 1);
+    }
+}
+
+static int currentConfig() {
+    if (!scene.lodEnabled)
+        return 0;
+    return scene.hysteresis > 0 ? 2 : 1;
+}
+
+static void printConfig() {
+    printf("%s; threshold %.2f pixels%s\n", configNames[currentConfig()],
+        scene.threshold, scene.tinted ? "; tinted by level" : "");
+}
+
+static void keyCallback(GLFWwindow *window, int key, int scancode,
+                        int action, int mods) {
+    if (action != GLFW_PRESS)
+        return;
+    switch (key) {
+    case GLFW_KEY_L:
+        scene.lodEnabled = !scene.lodEnabled;
+        break;
+    case GLFW_KEY_H:
+        scene.hysteresis = scene.hysteresis > 0 ? 0 : defaultHysteresis;
+        break;
+    case GLFW_KEY_T:
+        scene.tinted = !scene.tinted;
+        break;
+    case GLFW_KEY_EQUAL:
+        if (scene.threshold < 16)
+            scene.threshold *= 2;
+        break;
+    case GLFW_KEY_MINUS:
+        if (scene.threshold > 0.125f)
+            scene.threshold /= 2;
+        break;
+    default:
+        return;
+    }
+    printConfig();
+}
+
+static void init(GLFWwindow **window) {
+    // Set error callback to see more detailed failure info
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    glfwWindowHint(GLFW_SAMPLES, 4); // 4x antialiasing
+
+    // To ensure compatiblity, check the output of this command:
+    // $ glxinfo | grep 'Max core profile version'
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+    // To make MacOS happy
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // We don't want the old OpenGL
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Open a window and create its OpenGL context
+    *window = glfwCreateWindow(sceneWidth, sceneHeight,
+        "Tutorial 11 - Levels of detail", NULL, NULL);
+    if (!*window) {
+        fputs("Failed to open GLFW window.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(*window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(*window, GLFW_STICKY_KEYS, GL_TRUE);
+    glfwSetKeyCallback(*window, keyCallback);
+    // Don't wait for vsync, so frame times mean something
+    glfwSwapInterval(0);
+
+    // Black background, for space
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+
+    // Enable depth test
+    glEnable(GL_DEPTH_TEST);
+    // Accept fragment if it's closer to the camera than the former one
+    glDepthFunc(GL_LESS);
+    // The asteroid is closed, so its back faces never show
+    glEnable(GL_CULL_FACE);
+
+    buildBelt();
+
+    // Make the VAO.
+    GLuint vaoID;
+    glGenVertexArrays(1, &vaoID);
+    glBindVertexArray(vaoID);
+    vertexAttribs();
+    instanceAttribs();
+    // The VAO is ready.
+
+    // Create and compile our GLSL program from the shaders
+    scene.programID = loadShaders("asteroid-vertex.glsl",
+        "asteroid-fragment.glsl");
+    glUseProgram(scene.programID);
+    scene.vpID = glGetUniformLocation(scene.programID, "VP");
+    scene.tintID = glGetUniformLocation(scene.programID, "tint");
+
+    for (int level = 0; level < asteroidLodCount; level++)
+        printf("Level %d: %u triangles, error %.4f\n", level,
+            asteroidLods[level].indexCount / 3, asteroidLods[level].error);
+    puts("Initialized.");
+}
+
+// The six planes of the view frustum, each as (normal, distance) with the
+// normal pointing inwards, taken straight from the view-projection matrix.
+static void frustumPlanes(const glm::mat4 &vp, glm::vec4 planes[6]) {
+    glm::vec4 rows[4];
+    for (int r = 0; r < 4; r++)
+        rows[r] = glm::vec4(vp[0][r], vp[1][r], vp[2][r], vp[3][r]);
+    for (int axis = 0; axis < 3; axis++) {
+        planes[axis*2]     = rows[3] + rows[axis];
+        planes[axis*2 + 1] = rows[3] - rows[axis];
+    }
+    for (int p = 0; p < 6; p++)
+        planes[p] /= glm::length(glm::vec3(planes[p].x, planes[p].y,
+            planes[p].z));
+}
+
+static bool sphereVisible(const glm::vec4 planes[6], glm::vec3 centre,
+                          float radius) {
+    for (int p = 0; p < 6; p++)
+        if (glm::dot(glm::vec3(planes[p].x, planes[p].y, planes[p].z), centre)
+            + planes[p].w < -radius)
+            return false;
+    return true;
+}
+
+// Colours for the levels when tinted: white for full detail, then warmer
+static const GLfloat levelTints[][3] = {
+    {1, 1, 1}, {0.6f, 1, 0.6f}, {0.6f, 0.8f, 1},
+    {1, 1, 0.4f}, {1, 0.6f, 0.3f}, {1, 0.3f, 0.3f},
+};
+
+static LodTotals drawFrame(float time) {
+    LodTotals totals = {};
+    totals.frames = 1;
+
+    // Fly round the belt, inside it
+    float orbit = time * 0.05f;
+    glm::vec3 eye(80 * cosf(orbit), 4, 80 * sinf(orbit));
+    glm::vec3 ahead(-sinf(orbit), -0.05f, cosf(orbit));
+    glm::mat4 projection = glm::perspective(fovY,
+        (float)sceneWidth / sceneHeight, 0.1f, 400.f);
+    glm::mat4 view = glm::lookAt(eye, eye + ahead, glm::vec3(0, 1, 0));
+    glm::mat4 vp = projection * view;
+
+    glm::vec4 planes[6];
+    frustumPlanes(vp, planes);
+
+    // Pick each visible asteroid's level from how many pixels its error
+    // would cover, and gather it with the others at that level
+    for (int level = 0; level < asteroidLodCount; level++)
+        scene.instances[level].clear();
+    for (Asteroid &a: scene.asteroids) {
+        if (!sphereVisible(planes, a.position, a.scale * meshRadius))
+            continue;
+        int level = 0;
+        if (scene.lodEnabled) {
+            // The errors are in model units, so scale them with the model
+            float pixels = pixelsPerUnit(glm::length(a.position - eye), fovY,
+                sceneHeight) * a.scale;
+            level = selectLod(scene.errors, asteroidLodCount, pixels,
+                scene.threshold, scene.hysteresis, a.lod);
+        }
+        if (level != a.lod)
+            totals.switches++;
+        a.lod = level;
+
+        glm::mat4 model = glm::translate(glm::mat4(1), a.position);
+        model = glm::rotate(model, time * a.spinSpeed, a.spinAxis);
+        scene.instances[level].push_back(glm::scale(model,
+            glm::vec3(a.scale)));
+    }
+
+    // Orphan last frame's instance data rather than waiting for the GPU to
+    // finish with it, then upload each level's after the last
+    glBindBuffer(GL_ARRAY_BUFFER, scene.instanceVBOID);
+    glBufferData(GL_ARRAY_BUFFER, asteroidCount * sizeof(glm::mat4), NULL,
+        GL_STREAM_DRAW);
+    size_t offsets[asteroidLodCount], offset = 0;
+    for (int level = 0; level < asteroidLodCount; level++) {
+        const std::vector<glm::mat4> &instances = scene.instances[level];
+        offsets[level] = offset;
+        glBufferSubData(GL_ARRAY_BUFFER, offset,
+            instances.size() * sizeof(glm::mat4), instances.data());
+        offset += instances.size() * sizeof(glm::mat4);
+    }
+
+    // Clear the screen
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    glUniformMatrix4fv(scene.vpID, 1, GL_FALSE, &vp[0][0]);
+    static const GLfloat white[3] = {1, 1, 1};
+    // One instanced draw per level
+    for (int level = 0; level < asteroidLodCount; level++) {
+        size_t count = scene.instances[level].size();
+        totals.perLevel[level] = count;
+        if (!count)
+            continue;
+        const AsteroidLod &lod = asteroidLods[level];
+        totals.visible += count;
+        totals.triangles += count * lod.indexCount / 3;
+        totals.vertices += count * lod.vertexCount;
+
+        glUniform3fv(scene.tintID, 1,
+            scene.tinted ? levelTints[level] : white);
+        // GL 3.3 can't start an instanced draw part way through the
+        // instances, so point the per-instance attributes there
+        for (GLuint column = 0; column < 4; column++)
+            glVertexAttribPointer(2 + column, 4, GL_FLOAT, GL_FALSE,
+                sizeof(glm::mat4), (const void*)(uintptr_t)
+                (offsets[level] + column*sizeof(glm::vec4)));
+        glDrawElementsInstanced(GL_TRIANGLES, lod.indexCount, GL_UNSIGNED_INT,
+            (const void*)(uintptr_t)(lod.firstIndex * sizeof(GLuint)), count);
+    }
+
+    return totals;
+}
+
+static void addTotals(LodTotals &to, const LodTotals &from) {
+    to.frames += from.frames;
+    to.frameSeconds += from.frameSeconds;
+    to.visible += from.visible;
+    to.triangles += from.triangles;
+    to.vertices += from.vertices;
+    to.switches += from.switches;
+    for (int level = 0; level < asteroidLodCount; level++)
+        to.perLevel[level] += from.perLevel[level];
+}
+
+static void printHeader() {
+    printf("%-12s %8s %10s %10s %9s %9s  %s\n", "config", "visible",
+        "ktris", "kverts", "switches", "frame ms", "asteroids per level");
+}
+
+static void printRow(int config, const LodTotals &t) {
+    if (!t.frames)
+        return;
+    double n = t.frames;
+    printf("%-12s %8.0f %10.1f %10.1f %9.1f %9.3f ", configNames[config],
+        t.visible / n, t.triangles / n / 1000, t.vertices / n / 1000,
+        t.switches / n, t.frameSeconds * 1e3 / n);
+    for (int level = 0; level < asteroidLodCount; level++)
+        printf(" %5.0f", t.perLevel[level] / n);
+    putchar('\n');
+}
+
+static void printStats() {
+    puts("\nAverage per frame:");
+    printHeader();
+    for (int config = 0; config < configCount; config++)
+        printRow(config, scene.totals[config]);
+
+    // How much the levels save over drawing everything at full detail
+    const LodTotals &full = scene.totals[0];
+    for (int config = 1; config < configCount; config++) {
+        const LodTotals &t = scene.totals[config];
+        if (!full.frames || !t.frames || !full.triangles)
+            continue;
+        double fullFrame = full.frameSeconds / full.frames,
+               frame = t.frameSeconds / t.frames;
+        printf("%s draws %.1f%% of the triangles, in %.1f%% of the time\n",
+            configNames[config],
+            100.0 * t.triangles / t.frames / (full.triangles / full.frames),
+            100 * frame / fullFrame);
+    }
+}
+
+int main(int argc, char **argv) {
+    markMainStart();
+
+    bool bench = argc == 2 && !strcmp(argv[1], "bench");
+    if (argc > 1 && !bench) {
+        fputs("Usage: 11 [bench]\n"
+              "  bench flies the same path at full detail, then with levels\n"
+              "  of detail chosen without and with hysteresis, then exits.\n"
+              "  Otherwise, L toggles levels of detail, H hysteresis, T\n"
+              "  tinting by level, and +/- double or halve the threshold.\n",
+              stderr);
+        return 1;
+    }
+
+    scene.lodEnabled = !bench;
+    scene.tinted = false;
+    scene.threshold = 1;
+    scene.hysteresis = bench ? 0 : defaultHysteresis;
+
+    GLFWwindow *window;
+    init(&window);
+    printConfig();
+
+    // In bench mode, every config flies the same path at the same speed per
+    // frame, whatever the frame rate, and the first few frames after a
+    // switch aren't counted.
+    const unsigned benchFrames = 600, warmupFrames = 10;
+    const float benchStep = 1 / 60.f;
+    unsigned configFrame = 0;
+    int config = currentConfig();
+    double lastTime = glfwGetTime(), lastReport = lastTime;
+
+    do {
+        float time = bench ? configFrame * benchStep : glfwGetTime();
+        LodTotals totals = drawFrame(time);
+
+        // Swap buffers
+        glfwSwapBuffers(window);
+        reportStartupTime();
+        glfwPollEvents();
+
+        double now = glfwGetTime();
+        totals.frameSeconds = now - lastTime;
+        lastTime = now;
+        if (configFrame >= warmupFrames) {
+            addTotals(scene.totals[config], totals);
+            addTotals(scene.window, totals);
+        }
+        configFrame++;
+        if (currentConfig() != config) {
+            config = currentConfig();
+            configFrame = 0;
+        }
+
+        if (bench && configFrame == warmupFrames + benchFrames) {
+            if (config + 1 == configCount)
+                break;
+            config++;
+            scene.lodEnabled = true;
+            scene.hysteresis = config == 2 ? defaultHysteresis : 0;
+            configFrame = 0;
+            printConfig();
+        }
+
+        if (!bench && now - lastReport >= 1) {
+            printHeader();
+            printRow(config, scene.window);
+            scene.window = {};
+            lastReport = now;
+        }
+
+        // Check if the ESC key was pressed or the window was closed
+    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+             !glfwWindowShouldClose(window));
+
+    printStats();
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}
@@ -0,0 +1,18 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec3 normal_worldspace;
+
+// Output data
+out vec4 color;
+
+// Multiplies the rock colour, to show which level of detail is drawn
+uniform vec3 tint;
+
+void main() {
+    // A distant sun, and a little light from everywhere else
+    vec3 toLight = normalize(vec3(0.6, 0.7, 0.4));
+    float diffuse = max(dot(normalize(normal_worldspace), toLight), 0);
+    vec3 rock = vec3(0.55, 0.5, 0.45);
+    color = vec4(rock * tint * (0.15 + 0.85 * diffuse), 1);
+}
@@ -0,0 +1,20 @@
+#version 330 core
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec3 vertexPosition_modelspace;
+layout(location = 1) in vec3 vertexNormal_modelspace;
+// Input instance data: each asteroid's model matrix, which takes up locations
+// 2-5 (one per column).
+layout(location = 2) in mat4 instanceModel;
+
+// Output data; will be interpolated for each fragment.
+out vec3 normal_worldspace;
+// Values that stay constant for the whole mesh.
+uniform mat4 VP;
+
+void main() {
+    gl_Position = VP * instanceModel * vec4(vertexPosition_modelspace, 1);
+
+    // Asteroids are only scaled evenly, so the model matrix does for normals
+    normal_worldspace = mat3(instanceModel) * vertexNormal_modelspace;
+}
@@ -0,0 +1,147 @@
+// Build step for tutorial 11: makes a lumpy asteroid mesh, simplifies it into
+// levels of detail with ../common/lod.hpp, and writes them all out as a C
+// header for the program to include. Simplifying takes a while, which is why
+// it's done here rather than at startup.
+
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include <map>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "../common/lod.hpp"
+
+// Triangle counts to simplify down to. The first is the full mesh.
+static const size_t targets[] = {20480, 6000, 2000, 600, 200, 60};
+static const int levelCount = sizeof(targets) / sizeof(targets[0]);
+
+// A sphere made by splitting the faces of an icosahedron, over and over. Its
+// vertices are shared between triangles, which the simplifier needs.
+static LodMesh icosphere(int subdivisions) {
+    const float t = (1 + sqrtf(5)) / 2;
+    LodMesh mesh;
+    mesh.positions = {
+        {-1, t, 0}, {1, t, 0}, {-1, -t, 0}, {1, -t, 0},
+        {0, -1, t}, {0, 1, t}, {0, -1, -t}, {0, 1, -t},
+        {t, 0, -1}, {t, 0, 1}, {-t, 0, -1}, {-t, 0, 1},
+    };
+    for (glm::vec3 &p: mesh.positions)
+        p = glm::normalize(p);
+    mesh.indices = {
+        0, 11, 5,  0, 5, 1,   0, 1, 7,   0, 7, 10,  0, 10, 11,
+        1, 5, 9,   5, 11, 4,  11, 10, 2, 10, 7, 6,  7, 1, 8,
+        3, 9, 4,   3, 4, 2,   3, 2, 6,   3, 6, 8,   3, 8, 9,
+        4, 9, 5,   2, 4, 11,  6, 2, 10,  8, 6, 7,   9, 8, 1,
+    };
+
+    for (int s = 0; s < subdivisions; s++) {
+        // Each edge's midpoint is made once, and shared by both its faces
+        std::map<std::pair<uint32_t, uint32_t>, uint32_t> midpoints;
+        auto midpoint = [&](uint32_t a, uint32_t b) {
+            std::pair<uint32_t, uint32_t> key(std::min(a, b), std::max(a, b));
+            auto found = midpoints.find(key);
+            if (found != midpoints.end())
+                return found->second;
+            uint32_t i = mesh.positions.size();
+            mesh.positions.push_back(glm::normalize(
+                mesh.positions[a] + mesh.positions[b]));
+            midpoints[key] = i;
+            return i;
+        };
+
+        std::vector<uint32_t> indices;
+        for (size_t f = 0; f < mesh.indices.size(); f += 3) {
+            uint32_t a = mesh.indices[f], b = mesh.indices[f + 1],
+                     c = mesh.indices[f + 2];
+            uint32_t ab = midpoint(a, b), bc = midpoint(b, c),
+                     ca = midpoint(c, a);
+            indices.insert(indices.end(),
+                {a, ab, ca,  b, bc, ab,  c, ca, bc,  ab, bc, ca});
+        }
+        mesh.indices.swap(indices);
+    }
+    return mesh;
+}
+
+// Lumps at a few scales, from waves in each axis
+static float lumpiness(glm::vec3 p) {
+    return 0.20f * sinf(2.1f * p.x + 1.3f) * sinf(2.7f * p.y + 0.4f)
+                 * sinf(2.3f * p.z + 2.1f)
+         + 0.08f * sinf(6.3f * p.x + 0.7f) * sinf(5.9f * p.y + 2.6f)
+                 * sinf(6.7f * p.z + 1.1f)
+         + 0.03f * sinf(17.f * p.x) * sinf(15.f * p.y + 1.f)
+                 * sinf(16.f * p.z + 2.f);
+}
+
+static std::vector<glm::vec3> vertexNormals(const LodMesh &mesh) {
+    std::vector<glm::vec3> normals(mesh.positions.size(), glm::vec3(0));
+    for (size_t f = 0; f < mesh.indices.size(); f += 3) {
+        const uint32_t *i = &mesh.indices[f];
+        // Not normalised, so bigger faces count for more
+        glm::vec3 n = glm::cross(
+            mesh.positions[i[1]] - mesh.positions[i[0]],
+            mesh.positions[i[2]] - mesh.positions[i[0]]);
+        for (int k = 0; k < 3; k++)
+            normals[i[k]] += n;
+    }
+    for (glm::vec3 &n: normals)
+        n = glm::normalize(n);
+    return normals;
+}
+
+int main() {
+    LodMesh mesh = icosphere(5);
+    for (glm::vec3 &p: mesh.positions)
+        p *= 1 + lumpiness(p);
+
+    std::vector<size_t> targetTriangles(targets, targets + levelCount);
+    std::vector<MeshLevel> levels = simplifyMesh(mesh, targetTriangles);
+
+    printf("// Generated by make-lods: an asteroid at %d levels of detail, "
+        "each with its\n// error in model units. Don't edit.\n\n", levelCount);
+    printf("static const int asteroidLodCount = %d;\n", levelCount);
+    puts("static const struct AsteroidLod {\n"
+         "    unsigned firstIndex, indexCount, vertexCount;\n"
+         "    float error;\n"
+         "} asteroidLods[] = {");
+    unsigned firstIndex = 0;
+    for (const MeshLevel &level: levels) {
+        printf("    {%u, %zu, %zu, %.6ff},\n", firstIndex,
+            level.mesh.indices.size(), level.mesh.positions.size(),
+            level.error);
+        firstIndex += level.mesh.indices.size();
+        fprintf(stderr, "%6zu triangles, %6zu vertices, error %.5f\n",
+            level.mesh.indices.size() / 3, level.mesh.positions.size(),
+            level.error);
+    }
+    puts("};\n");
+
+    puts("// Position then normal, for every vertex of every level in turn\n"
+         "static const GLfloat asteroidVertices[] = {");
+    for (const MeshLevel &level: levels) {
+        std::vector<glm::vec3> normals = vertexNormals(level.mesh);
+        for (size_t v = 0; v < level.mesh.positions.size(); v++) {
+            glm::vec3 p = level.mesh.positions[v], n = normals[v];
+            printf("    %.5ff,%.5ff,%.5ff, %.4ff,%.4ff,%.4ff,\n",
+                p.x, p.y, p.z, n.x, n.y, n.z);
+        }
+    }
+    puts("};\n");
+
+    puts("// Three per triangle, already offset to their level's vertices\n"
+         "static const GLuint asteroidIndices[] = {");
+    unsigned firstVertex = 0;
+    for (const MeshLevel &level: levels) {
+        const std::vector<uint32_t> &indices = level.mesh.indices;
+        for (size_t i = 0; i < indices.size(); i += 3)
+            printf("    %u,%u,%u,\n", firstVertex + indices[i],
+                firstVertex + indices[i + 1], firstVertex + indices[i + 2]);
+        firstVertex += level.mesh.positions.size();
+    }
+    puts("};");
+    return 0;
+}
@@ -0,0 +1,612 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+
+#include "../common/gltrace.h"
+#include "../common/lod.hpp"
+#include "../common/startup-time.h"
+#include "shaders.h"
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+static GLuint loadShader(const char *fn, GLenum shaderType) {
+    printf("Compiling shader '%s'...\n", fn);
+
+    GLuint shaderID = glCreateShader(shaderType);
+    if (!shaderID) {
+        fprintf(stderr, "Failed to create shader\n");
+        exit(1);
+    }
+
+    // Embedded at build time, unless SHADER_DIR says to read it from disk
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    glShaderSource(shaderID, 1, &source, &size);
+    free(allocated);
+
+    glCompileShader(shaderID);
+
+    GLint logLength;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength) {
+        GLchar *log = (GLchar*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetShaderInfoLog(shaderID, logLength, NULL, log);
+        printf("Shader compile message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    return shaderID;
+}
+
+static GLuint loadShaders(const char *vertex_fn, const char *fragment_fn) {
+    // Compile the shaders
+    GLuint vertexShaderID = loadShader(vertex_fn, GL_VERTEX_SHADER),
+           fragmentShaderID = loadShader(fragment_fn, GL_FRAGMENT_SHADER);
+
+    puts("Linking shader program...");
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    glLinkProgram(programID);
+
+    // Check the program
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0) {
+        char *log = (char*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetProgramInfoLog(programID, logLength, NULL, log);
+        printf("Shader link message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    return programID;
+}
+
+// A line on the map: an island's coastline, which is closed, or a river.
+// Each level of detail has its own copy of the points, in one buffer.
+struct Feature {
+    std::vector<glm::vec2> points;
+    bool closed;
+    glm::vec2 boundsMin, boundsMax;
+};
+
+struct FeatureRange {
+    GLint first;
+    GLsizei count;
+};
+
+enum Simplifier {
+    DOUGLAS_PEUCKER,
+    VISVALINGAM,
+    SIMPLIFIER_COUNT
+};
+
+static const char *const simplifierNames[SIMPLIFIER_COUNT] = {
+    "Douglas-Peucker", "Visvalingam"
+};
+
+static const int sceneWidth = 1024, sceneHeight = 768;
+// The map, in map units, fills the window at zoom 0
+static const float mapWidth = 4096, mapHeight = 3072;
+static const float baseScale = sceneWidth / mapWidth;
+static const int maxZoom = 7;
+static const int islandCount = 24, riverCount = 32;
+// Level 0 is the full detail; each after it aims for twice the error, starting
+// from what's invisible at the closest zoom
+static const int levelCount = maxZoom + 2;
+static const float defaultThreshold = 0.5f, defaultHysteresis = 0.25f;
+
+struct MapTotals {
+    unsigned frames;
+    double frameSeconds;
+    size_t vertices, draws, switches;
+};
+
+// What the bench compares: full detail, then each way of simplifying
+static const int configCount = 1 + SIMPLIFIER_COUNT;
+static const char *const configNames[configCount] = {
+    "full detail", "Douglas-Peucker", "Visvalingam"
+};
+
+static struct {
+    std::vector<Feature> features;
+    // What each level asks its simplifier for, and the worst error over all
+    // features that each simplifier actually gave; levels are picked by the
+    // latter
+    float tolerances[levelCount];
+    float errors[SIMPLIFIER_COUNT][levelCount];
+    // By level, then by feature: where its points are in the buffer
+    std::vector<FeatureRange> ranges[levelCount];
+    size_t levelPoints[levelCount];
+    double buildSeconds[SIMPLIFIER_COUNT];
+
+    Simplifier simplifier;
+    bool lodEnabled;
+    float threshold, hysteresis;
+    int lod;
+
+    GLuint vertexVBOID;
+    GLuint programID;
+    GLint centreID, scaleID, viewportID, colorID;
+
+    // By config, for the bench; window is since the last report
+    MapTotals totals[configCount], window;
+} scene;
+
+// Break each segment at its middle, nudged sideways by up to roughness times
+// its length, levels times over
+static void displaceMidpoints(std::vector<glm::vec2> &points, bool closed,
+                              int levels, float roughness,
+                              std::mt19937 &rng) {
+    std::uniform_real_distribution<float> nudge(-roughness, roughness);
+    for (int l = 0; l < levels; l++) {
+        std::vector<glm::vec2> finer;
+        size_t n = points.size(), segments = closed ? n : n - 1;
+        for (size_t i = 0; i < segments; i++) {
+            glm::vec2 a = points[i], b = points[(i + 1) % n];
+            glm::vec2 across(a.y - b.y, b.x - a.x);
+            finer.push_back(a);
+            finer.push_back((a + b) * 0.5f + across * nudge(rng));
+        }
+        if (!closed)
+            finer.push_back(points.back());
+        points.swap(finer);
+    }
+}
+
+static void buildMap() {
+    // A fixed seed, so every run draws the same map
+    std::mt19937 rng(12);
+    std::uniform_real_distribution<float> x(0, mapWidth), y(0, mapHeight),
+                                          unit(0, 1);
+    const float pi = 3.14159265f;
+
+    // Islands start as rough octagons; 9 rounds of splitting makes 4096
+    // points each
+    for (int i = 0; i < islandCount; i++) {
+        Feature f;
+        f.closed = true;
+        glm::vec2 centre(x(rng), y(rng));
+        float radius = 80 + 220 * unit(rng);
+        for (int k = 0; k < 8; k++) {
+            float angle = 2*pi * k / 8, r = radius * (0.7f + 0.6f * unit(rng));
+            f.points.push_back(centre + r * glm::vec2(cosf(angle),
+                sinf(angle)));
+        }
+        displaceMidpoints(f.points, true, 9, 0.3f, rng);
+        scene.features.push_back(f);
+    }
+    // Rivers start as a straight line; 11 rounds makes 2049 points
+    for (int i = 0; i < riverCount; i++) {
+        Feature f;
+        f.closed = false;
+        glm::vec2 source(x(rng), y(rng));
+        float angle = 2*pi * unit(rng), length = 300 + 500 * unit(rng);
+        f.points = {source,
+                    source + length * glm::vec2(cosf(angle), sinf(angle))};
+        displaceMidpoints(f.points, false, 11, 0.25f, rng);
+        scene.features.push_back(f);
+    }
+
+    for (Feature &f: scene.features) {
+        f.boundsMin = f.boundsMax = f.points[0];
+        for (glm::vec2 p: f.points) {
+            f.boundsMin = glm::vec2(fminf(f.boundsMin.x, p.x),
+                fminf(f.boundsMin.y, p.y));
+            f.boundsMax = glm::vec2(fmaxf(f.boundsMax.x, p.x),
+                fmaxf(f.boundsMax.y, p.y));
+        }
+    }
+
+    // What's threshold pixels at the closest zoom, doubling per level
+    scene.tolerances[0] = 0;
+    for (int level = 1; level < levelCount; level++)
+        scene.tolerances[level] = defaultThreshold
+                                  / (baseScale * (1 << maxZoom))
+                                  * (1 << (level - 1));
+}
+
+// Simplify every feature for every level and upload the lot, replacing what
+// was there, then measure each level's error. Returns how long the
+// simplifying took.
+static double buildLevels(Simplifier simplifier) {
+    double start = glfwGetTime();
+    std::vector<glm::vec2> vertices;
+    float *errors = scene.errors[simplifier];
+    for (int level = 0; level < levelCount; level++) {
+        scene.ranges[level].clear();
+        size_t before = vertices.size();
+        float tolerance = scene.tolerances[level];
+        for (const Feature &f: scene.features) {
+            std::vector<glm::vec2> points;
+            if (!level)
+                points = f.points;
+            else if (simplifier == DOUGLAS_PEUCKER)
+                points = simplifyDouglasPeucker(f.points, tolerance, f.closed);
+            else
+                // Visvalingam works by area, so take a triangle whose height
+                // is the tolerance as the smallest worth keeping. That
+                // doesn't bound how far the line strays, hence measuring.
+                points = simplifyVisvalingam(f.points, tolerance * tolerance,
+                    f.closed);
+            scene.ranges[level].push_back({(GLint)vertices.size(),
+                                           (GLsizei)points.size()});
+            vertices.insert(vertices.end(), points.begin(), points.end());
+        }
+        scene.levelPoints[level] = vertices.size() - before;
+    }
+    double seconds = glfwGetTime() - start;
+
+    // selectLod() wants errors that never shrink from one level to the next
+    for (int level = 0; level < levelCount; level++) {
+        errors[level] = level ? errors[level - 1] : 0;
+        for (size_t i = 0; level && i < scene.features.size(); i++) {
+            const Feature &f = scene.features[i];
+            const FeatureRange &range = scene.ranges[level][i];
+            std::vector<glm::vec2> points(vertices.begin() + range.first,
+                vertices.begin() + range.first + range.count);
+            errors[level] = fmaxf(errors[level],
+                simplificationError(f.points, points, f.closed));
+        }
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, scene.vertexVBOID);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2),
+        vertices.data(), GL_STATIC_DRAW);
+    return seconds;
+}
+
+static void printLevels() {
+    printf("Levels by %s, built in %.1f ms:", simplifierNames[scene.simplifier],
+        scene.buildSeconds[scene.simplifier] * 1e3);
+    for (int level = 0; level < levelCount; level++)
+        printf(" %zu", scene.levelPoints[level]);
+    puts(" points");
+    printf("  worst error, in map units (tolerance):");
+    for (int level = 1; level < levelCount; level++)
+        printf(" %.2f (%.2f)", scene.errors[scene.simplifier][level],
+            scene.tolerances[level]);
+    putchar('\n');
+}
+
+static void vertexAttribs() {
+    glGenBuffers(1, &scene.vertexVBOID);
+    glBindBuffer(GL_ARRAY_BUFFER, scene.vertexVBOID);
+    // 1st attribute buffer: positions
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, NULL);
+}
+
+static int currentConfig() {
+    return scene.lodEnabled ? 1 + scene.simplifier : 0;
+}
+
+static void printConfig() {
+    printf("%s; threshold %.2f pixels, hysteresis %.2f\n",
+        configNames[currentConfig()], scene.threshold, scene.hysteresis);
+}
+
+static void setSimplifier(Simplifier simplifier) {
+    scene.simplifier = simplifier;
+    scene.buildSeconds[simplifier] = buildLevels(simplifier);
+    printLevels();
+}
+
+static void keyCallback(GLFWwindow *window, int key, int scancode,
+                        int action, int mods) {
+    if (action != GLFW_PRESS)
+        return;
+    switch (key) {
+    case GLFW_KEY_A:
+        setSimplifier((Simplifier)((scene.simplifier + 1) % SIMPLIFIER_COUNT));
+        break;
+    case GLFW_KEY_L:
+        scene.lodEnabled = !scene.lodEnabled;
+        break;
+    case GLFW_KEY_H:
+        scene.hysteresis = scene.hysteresis > 0 ? 0 : defaultHysteresis;
+        break;
+    case GLFW_KEY_EQUAL:
+        if (scene.threshold < 16)
+            scene.threshold *= 2;
+        break;
+    case GLFW_KEY_MINUS:
+        if (scene.threshold > 0.125f)
+            scene.threshold /= 2;
+        break;
+    default:
+        return;
+    }
+    printConfig();
+}
+
+static void init(GLFWwindow **window) {
+    // Set error callback to see more detailed failure info
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    glfwWindowHint(GLFW_SAMPLES, 4); // 4x antialiasing
+
+    // To ensure compatiblity, check the output of this command:
+    // $ glxinfo | grep 'Max core profile version'
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+    // To make MacOS happy
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // We don't want the old OpenGL
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Open a window and create its OpenGL context
+    *window = glfwCreateWindow(sceneWidth, sceneHeight,
+        "Tutorial 12 - Map levels of detail", NULL, NULL);
+    if (!*window) {
+        fputs("Failed to open GLFW window.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(*window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(*window, GLFW_STICKY_KEYS, GL_TRUE);
+    glfwSetKeyCallback(*window, keyCallback);
+    // Don't wait for vsync, so frame times mean something
+    glfwSwapInterval(0);
+
+    // Dark blue background, for the sea
+    glClearColor(0.0, 0.0, 0.4, 0.0);
+
+    // Make the VAO.
+    GLuint vaoID;
+    glGenVertexArrays(1, &vaoID);
+    glBindVertexArray(vaoID);
+    vertexAttribs();
+    // The VAO is ready.
+
+    buildMap();
+    setSimplifier(scene.simplifier);
+
+    // Create and compile our GLSL program from the shaders
+    scene.programID = loadShaders("line-vertex.glsl", "line-fragment.glsl");
+    glUseProgram(scene.programID);
+    scene.centreID = glGetUniformLocation(scene.programID, "centre");
+    scene.scaleID = glGetUniformLocation(scene.programID, "scale");
+    scene.viewportID = glGetUniformLocation(scene.programID, "viewport");
+    scene.colorID = glGetUniformLocation(scene.programID, "lineColor");
+    glUniform2f(scene.viewportID, sceneWidth, sceneHeight);
+
+    puts("Initialized.");
+}
+
+static MapTotals drawFrame(float time) {
+    MapTotals totals = {};
+    totals.frames = 1;
+
+    // Zoom in and out of the first island's coast, with a small wobble that
+    // keeps crossing level boundaries; that's what hysteresis is for
+    float zoom = maxZoom * (0.5f - 0.5f * cosf(time * 0.3f))
+                 + 0.1f * sinf(time * 7);
+    zoom = glm::clamp(zoom, 0.f, (float)maxZoom);
+    float scale = baseScale * exp2f(zoom);
+    glm::vec2 mapCentre(mapWidth / 2, mapHeight / 2);
+    glm::vec2 centre = mapCentre + (scene.features[0].points[0] - mapCentre)
+                                   * (zoom / maxZoom);
+
+    int level = 0;
+    if (scene.lodEnabled)
+        level = selectLod(scene.errors[scene.simplifier], levelCount, scale,
+            scene.threshold, scene.hysteresis, scene.lod);
+    if (level != scene.lod)
+        totals.switches++;
+    scene.lod = level;
+
+    // Clear the screen
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glUniform2f(scene.centreID, centre.x, centre.y);
+    glUniform1f(scene.scaleID, scale);
+
+    // Only the features whose bounds reach into the window
+    glm::vec2 half = glm::vec2(sceneWidth, sceneHeight) / (2 * scale);
+    glm::vec2 viewMin = centre - half, viewMax = centre + half;
+    static const GLfloat coastColor[3] = {0.9f, 0.8f, 0.5f},
+                         riverColor[3] = {0.4f, 0.7f, 1};
+    bool coast = false;
+    for (size_t i = 0; i < scene.features.size(); i++) {
+        const Feature &f = scene.features[i];
+        if (f.boundsMax.x < viewMin.x || f.boundsMin.x > viewMax.x
+            || f.boundsMax.y < viewMin.y || f.boundsMin.y > viewMax.y)
+            continue;
+        // Islands come first, so the colour changes at most twice
+        if (!totals.draws || coast != f.closed) {
+            coast = f.closed;
+            glUniform3fv(scene.colorID, 1, coast ? coastColor : riverColor);
+        }
+        const FeatureRange &range = scene.ranges[level][i];
+        glDrawArrays(f.closed ? GL_LINE_LOOP : GL_LINE_STRIP, range.first,
+            range.count);
+        totals.vertices += range.count;
+        totals.draws++;
+    }
+
+    return totals;
+}
+
+static void addTotals(MapTotals &to, const MapTotals &from) {
+    to.frames += from.frames;
+    to.frameSeconds += from.frameSeconds;
+    to.vertices += from.vertices;
+    to.draws += from.draws;
+    to.switches += from.switches;
+}
+
+static void printHeader() {
+    printf("%-16s %10s %8s %9s %9s\n", "config", "kverts", "draws",
+        "switches", "frame ms");
+}
+
+static void printRow(int config, const MapTotals &t) {
+    if (!t.frames)
+        return;
+    double n = t.frames;
+    printf("%-16s %10.1f %8.1f %9.3f %9.3f\n", configNames[config],
+        t.vertices / n / 1000, t.draws / n, t.switches / n,
+        t.frameSeconds * 1e3 / n);
+}
+
+static void printStats() {
+    puts("\nAverage per frame:");
+    printHeader();
+    for (int config = 0; config < configCount; config++)
+        printRow(config, scene.totals[config]);
+
+    const MapTotals &full = scene.totals[0];
+    for (int s = 0; s < SIMPLIFIER_COUNT; s++) {
+        const MapTotals &t = scene.totals[1 + s];
+        if (!full.frames || !t.frames || !full.vertices)
+            continue;
+        // Levels were picked by measured error, so this compares the two at
+        // the same on-screen accuracy
+        printf("%s: built in %.1f ms, strays up to %.2f map units at level "
+            "1; draws %.1f%% of the vertices, in %.1f%% of the time\n",
+            simplifierNames[s], scene.buildSeconds[s] * 1e3,
+            scene.errors[s][1],
+            100.0 * t.vertices / t.frames / (full.vertices / full.frames),
+            100.0 * t.frameSeconds / t.frames
+            / (full.frameSeconds / full.frames));
+    }
+}
+
+int main(int argc, char **argv) {
+    markMainStart();
+
+    bool bench = argc == 2 && !strcmp(argv[1], "bench");
+    if (argc > 1 && !bench) {
+        fputs("Usage: 12 [bench]\n"
+              "  bench zooms the same way at full detail, then with levels\n"
+              "  from each simplifier, then exits.\n"
+              "  Otherwise, L toggles levels of detail, A switches the\n"
+              "  simplifier, H toggles hysteresis and +/- double or halve\n"
+              "  the threshold.\n",
+              stderr);
+        return 1;
+    }
+
+    scene.simplifier = DOUGLAS_PEUCKER;
+    scene.lodEnabled = !bench;
+    scene.threshold = defaultThreshold;
+    scene.hysteresis = defaultHysteresis;
+
+    GLFWwindow *window;
+    init(&window);
+    printConfig();
+
+    // In bench mode, every config zooms the same way per frame, whatever the
+    // frame rate, and the first few frames after a switch aren't counted.
+    const unsigned benchFrames = 600, warmupFrames = 10;
+    const float benchStep = 1 / 60.f;
+    unsigned configFrame = 0;
+    int config = currentConfig();
+    double lastTime = glfwGetTime(), lastReport = lastTime;
+
+    do {
+        float time = bench ? configFrame * benchStep : glfwGetTime();
+        MapTotals totals = drawFrame(time);
+
+        // Swap buffers
+        glfwSwapBuffers(window);
+        reportStartupTime();
+        glfwPollEvents();
+
+        double now = glfwGetTime();
+        totals.frameSeconds = now - lastTime;
+        lastTime = now;
+        if (configFrame >= warmupFrames) {
+            addTotals(scene.totals[config], totals);
+            addTotals(scene.window, totals);
+        }
+        configFrame++;
+        if (currentConfig() != config) {
+            config = currentConfig();
+            configFrame = 0;
+        }
+
+        if (bench && configFrame == warmupFrames + benchFrames) {
+            if (config + 1 == configCount)
+                break;
+            config++;
+            scene.lodEnabled = true;
+            if (config - 1 != scene.simplifier)
+                setSimplifier((Simplifier)(config - 1));
+            configFrame = 0;
+            printConfig();
+        }
+
+        if (!bench && now - lastReport >= 1) {
+            printf("Drawing level %d of %d\n", scene.lod, levelCount - 1);
+            printHeader();
+            printRow(config, scene.window);
+            scene.window = {};
+            lastReport = now;
+        }
+
+        // Check if the ESC key was pressed or the window was closed
+    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+             !glfwWindowShouldClose(window));
+
+    printStats();
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}
@@ -0,0 +1,11 @@
+#version 330 core
+
+// Output data
+out vec4 color;
+
+// The same for every line of a feature
+uniform vec3 lineColor;
+
+void main() {
+    color = vec4(lineColor, 1);
+}
@@ -0,0 +1,15 @@
+#version 330 core
+
+// Input vertex data, different for all executions of this shader.
+layout(location = 0) in vec2 vertexPosition_mapspace;
+
+// Where the view is centred on the map, how many pixels one map unit covers,
+// and the size of the window in pixels.
+uniform vec2 centre;
+uniform float scale;
+uniform vec2 viewport;
+
+void main() {
+    vec2 pixels = (vertexPosition_mapspace - centre) * scale;
+    gl_Position = vec4(pixels / viewport * 2, 0, 1);
+}
@@ -0,0 +1,622 @@
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "../common/gltrace.h"
+#include "../common/startup-time.h"
+#include "shaders.h"
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+static GLuint loadShader(const char *fn, GLenum shaderType) {
+    printf("Compiling shader '%s'...\n", fn);
+
+    GLuint shaderID = glCreateShader(shaderType);
+    if (!shaderID) {
+        fprintf(stderr, "Failed to create shader\n");
+        exit(1);
+    }
+
+    // Embedded at build time, unless SHADER_DIR says to read it from disk
+    GLint size;
+    char *allocated;
+    const GLchar *source = shaderSource(embeddedShaders, embeddedShaderCount,
+        fn, &size, &allocated);
+    glShaderSource(shaderID, 1, &source, &size);
+    free(allocated);
+
+    glCompileShader(shaderID);
+
+    GLint logLength;
+    glGetShaderiv(shaderID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength) {
+        GLchar *log = (GLchar*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetShaderInfoLog(shaderID, logLength, NULL, log);
+        printf("Shader compile message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetShaderiv(shaderID, GL_COMPILE_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    return shaderID;
+}
+
+static GLuint loadShaders(const char *vertex_fn, const char *fragment_fn) {
+    // Compile the shaders
+    GLuint vertexShaderID = loadShader(vertex_fn, GL_VERTEX_SHADER),
+           fragmentShaderID = loadShader(fragment_fn, GL_FRAGMENT_SHADER);
+
+    puts("Linking shader program...");
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    glAttachShader(programID, fragmentShaderID);
+    glLinkProgram(programID);
+
+    // Check the program
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0) {
+        char *log = (char*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetProgramInfoLog(programID, logLength, NULL, log);
+        printf("Shader link message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    glDetachShader(programID, vertexShaderID);
+    glDetachShader(programID, fragmentShaderID);
+    glDeleteShader(vertexShaderID);
+    glDeleteShader(fragmentShaderID);
+
+    return programID;
+}
+
+// A program with only a vertex shader, whose outputs named in varyings are
+// captured into buffers by transform feedback. The names have to be given
+// before linking.
+static GLuint loadFeedbackShader(const char *vertex_fn,
+                                 const char *const *varyings, int count) {
+    GLuint vertexShaderID = loadShader(vertex_fn, GL_VERTEX_SHADER);
+
+    puts("Linking shader program...");
+
+    GLuint programID = glCreateProgram();
+    glAttachShader(programID, vertexShaderID);
+    // One after another in a single buffer, as the particles are laid out
+    glTransformFeedbackVaryings(programID, count, varyings,
+        GL_INTERLEAVED_ATTRIBS);
+    glLinkProgram(programID);
+
+    // Check the program
+    GLint logLength;
+    glGetProgramiv(programID, GL_INFO_LOG_LENGTH, &logLength);
+    if (logLength > 0) {
+        char *log = (char*)malloc(logLength);
+        if (!log) {
+            perror("Couldn't allocate shader compile log");
+            exit(1);
+        }
+        glGetProgramInfoLog(programID, logLength, NULL, log);
+        printf("Shader link message: %s\n", log);
+        free(log);
+    }
+
+    GLint status;
+    glGetProgramiv(programID, GL_LINK_STATUS, &status);
+    if (!status)
+        exit(1);
+
+    glDetachShader(programID, vertexShaderID);
+    glDeleteShader(vertexShaderID);
+
+    return programID;
+}
+
+// What the update reads and writes for each particle; the shaders see it as
+// two vec4s
+struct Particle {
+    glm::vec3 position;
+    float age;
+    glm::vec3 velocity;
+    float lifetime;
+};
+
+enum UpdateMode {
+    // Step every particle on the CPU and upload them all, every frame
+    UPDATE_CPU,
+    // Step them in a vertex shader, from one buffer into the other
+    UPDATE_GPU,
+    UPDATE_MODE_COUNT
+};
+
+static const char *const updateModeNames[UPDATE_MODE_COUNT] = {
+    "CPU", "GPU"
+};
+
+static const int sceneWidth = 1024, sceneHeight = 768;
+static const int countSteps[] = {4096, 32768, 262144, 1048576, 4194304};
+static const int countStepCount = sizeof(countSteps) / sizeof(countSteps[0]);
+// Results come back this many frames late, so reading them doesn't wait
+static const int queryLatency = 3;
+
+struct UpdateTotals {
+    unsigned frames, gpuFrames;
+    double frameSeconds, updateSeconds, gpuSeconds;
+};
+
+static struct {
+    UpdateMode mode;
+    int countStep;
+    float time;
+
+    // For the CPU path; the GPU path never reads the particles back
+    std::vector<Particle> particles;
+    // The GPU path reads one buffer and writes the other, then swaps. The
+    // CPU path only uses the first.
+    GLuint particleVBOIDs[2];
+    GLuint vaoIDs[2];
+    int source;
+
+    GLuint updateProgramID, drawProgramID;
+    GLint dtID, timeID, vpID, pointScaleID, brightnessID;
+
+    // GPU time of the update step, by config
+    GLuint queryIDs[queryLatency];
+    int queryConfigs[queryLatency];
+    bool queryPending[queryLatency];
+
+    // By mode and by step in countSteps, for the bench; window is since the
+    // last report
+    UpdateTotals totals[UPDATE_MODE_COUNT][countStepCount], window;
+} scene;
+
+static int particleCount() {
+    return countSteps[scene.countStep];
+}
+
+// The same hash and update as particle-update.glsl, so both paths simulate
+// the same thing
+static uint32_t hash(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static float random(uint32_t seed) {
+    return (hash(seed) >> 8) / 16777216.f;
+}
+
+static void updateParticles(float dt, float time) {
+    uint32_t timeBits;
+    memcpy(&timeBits, &time, sizeof(timeBits));
+    for (size_t i = 0; i < scene.particles.size(); i++) {
+        Particle &p = scene.particles[i];
+        p.age += dt;
+        if (p.age >= p.lifetime) {
+            uint32_t seed = hash(i ^ timeBits);
+            float angle = 6.2831853f * random(seed),
+                  spread = 0.3f * random(seed + 1),
+                  speed = 8 + 4 * random(seed + 2);
+            p.position = glm::vec3(0);
+            p.velocity = glm::vec3(cosf(angle) * spread, 1,
+                sinf(angle) * spread) * speed;
+            p.age = 0;
+            p.lifetime = 2 + 3 * random(seed + 3);
+            continue;
+        }
+        glm::vec3 acceleration = glm::vec3(0, -9.8f, 0)
+                               + 1.5f * glm::vec3(-p.position.z, 0,
+                                                  p.position.x);
+        p.velocity += acceleration * dt;
+        p.velocity *= 1 - 0.1f * dt;
+        p.position += p.velocity * dt;
+        if (p.position.y < 0) {
+            p.position.y = -p.position.y;
+            p.velocity.y *= -0.5f;
+        }
+    }
+}
+
+// Start again with every particle at the fountain, waiting a different time
+// to be launched, so that they leave in a stream rather than all at once
+static void resetParticles() {
+    int count = particleCount();
+    std::vector<Particle> initial(count);
+    for (int i = 0; i < count; i++)
+        initial[i] = {glm::vec3(0), 0, glm::vec3(0), 5 * random(i)};
+
+    // Both buffers get the same size; the GPU path writes all of one from
+    // the other every frame
+    for (int b = 0; b < 2; b++) {
+        glBindBuffer(GL_ARRAY_BUFFER, scene.particleVBOIDs[b]);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(Particle),
+            b ? NULL : initial.data(),
+            scene.mode == UPDATE_CPU ? GL_STREAM_DRAW : GL_DYNAMIC_COPY);
+    }
+    scene.source = 0;
+    if (scene.mode == UPDATE_CPU)
+        scene.particles.swap(initial);
+    else
+        // Not needed, so don't keep it
+        std::vector<Particle>().swap(scene.particles);
+    scene.time = 0;
+}
+
+static void particleAttribs() {
+    glGenBuffers(2, scene.particleVBOIDs);
+    glGenVertexArrays(2, scene.vaoIDs);
+    // One VAO per buffer, read both by the update and by the draw
+    for (int b = 0; b < 2; b++) {
+        glBindVertexArray(scene.vaoIDs[b]);
+        glBindBuffer(GL_ARRAY_BUFFER, scene.particleVBOIDs[b]);
+        // 1st attribute buffer: position and age
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, sizeof(Particle),
+            (const void*)offsetof(Particle, position));
+        // 2nd attribute buffer: velocity and lifetime
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Particle),
+            (const void*)offsetof(Particle, velocity));
+    }
+}
+
+static void printConfig() {
+    printf("Updating %d particles on the %s\n", particleCount(),
+        updateModeNames[scene.mode]);
+}
+
+static void keyCallback(GLFWwindow *window, int key, int scancode,
+                        int action, int mods) {
+    if (action != GLFW_PRESS)
+        return;
+    switch (key) {
+    case GLFW_KEY_C:
+        scene.mode = (UpdateMode)((scene.mode + 1) % UPDATE_MODE_COUNT);
+        break;
+    case GLFW_KEY_EQUAL:
+        if (scene.countStep + 1 < countStepCount)
+            scene.countStep++;
+        break;
+    case GLFW_KEY_MINUS:
+        if (scene.countStep > 0)
+            scene.countStep--;
+        break;
+    default:
+        return;
+    }
+    // The GPU's particles aren't read back, so switching starts afresh
+    resetParticles();
+    printConfig();
+}
+
+static void init(GLFWwindow **window) {
+    // Set error callback to see more detailed failure info
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    // To ensure compatiblity, check the output of this command:
+    // $ glxinfo | grep 'Max core profile version'
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+
+    // To make MacOS happy
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+
+    // We don't want the old OpenGL
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+
+    // Open a window and create its OpenGL context
+    *window = glfwCreateWindow(sceneWidth, sceneHeight,
+        "Tutorial 13 - GPU particles", NULL, NULL);
+    if (!*window) {
+        fputs("Failed to open GLFW window.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(*window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+
+    // Ensure we can capture the escape key being pressed below
+    glfwSetInputMode(*window, GLFW_STICKY_KEYS, GL_TRUE);
+    glfwSetKeyCallback(*window, keyCallback);
+    // Don't wait for vsync, so frame times mean something
+    glfwSwapInterval(0);
+
+    // Black background, so the particles glow
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+
+    // Particles add light rather than hide each other, so their order
+    // doesn't matter and there's no depth test
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_ONE, GL_ONE);
+    // Let the vertex shader size the points
+    glEnable(GL_PROGRAM_POINT_SIZE);
+
+    particleAttribs();
+    resetParticles();
+    glGenQueries(queryLatency, scene.queryIDs);
+
+    // Create and compile our GLSL programs from the shaders
+    static const char *const varyings[] = {
+        "nextPositionAge", "nextVelocityLifetime"
+    };
+    scene.updateProgramID = loadFeedbackShader("particle-update.glsl",
+        varyings, 2);
+    scene.dtID = glGetUniformLocation(scene.updateProgramID, "dt");
+    scene.timeID = glGetUniformLocation(scene.updateProgramID, "time");
+    scene.drawProgramID = loadShaders("particle-vertex.glsl",
+        "particle-fragment.glsl");
+    scene.vpID = glGetUniformLocation(scene.drawProgramID, "VP");
+    scene.pointScaleID = glGetUniformLocation(scene.drawProgramID,
+        "pointScale");
+    scene.brightnessID = glGetUniformLocation(scene.drawProgramID,
+        "brightness");
+
+    puts("Initialized.");
+}
+
+static void addTotals(UpdateTotals &to, const UpdateTotals &from) {
+    to.frames += from.frames;
+    to.gpuFrames += from.gpuFrames;
+    to.frameSeconds += from.frameSeconds;
+    to.updateSeconds += from.updateSeconds;
+    to.gpuSeconds += from.gpuSeconds;
+}
+
+// Collect the GPU time of the update queryLatency frames ago into its config's
+// totals and the report window, and start timing this one in its place. A
+// config of -1 is timed but not counted.
+static void beginGPUTimer(unsigned frame, int config) {
+    int slot = frame % queryLatency;
+    if (scene.queryPending[slot]) {
+        GLuint64 nanoseconds;
+        glGetQueryObjectui64v(scene.queryIDs[slot], GL_QUERY_RESULT,
+            &nanoseconds);
+        int c = scene.queryConfigs[slot];
+        if (c >= 0) {
+            UpdateTotals gpu = {};
+            gpu.gpuFrames = 1;
+            gpu.gpuSeconds = nanoseconds * 1e-9;
+            addTotals(scene.totals[c / countStepCount][c % countStepCount],
+                gpu);
+            addTotals(scene.window, gpu);
+        }
+    }
+    scene.queryConfigs[slot] = config;
+    scene.queryPending[slot] = true;
+    glBeginQuery(GL_TIME_ELAPSED, scene.queryIDs[slot]);
+}
+
+// Step the particles, on the CPU or the GPU. Returns the CPU time it took.
+static double update(float dt) {
+    double start = glfwGetTime();
+    int count = particleCount();
+    scene.time += dt;
+
+    if (scene.mode == UPDATE_CPU) {
+        updateParticles(dt, scene.time);
+        // Orphan the old data rather than waiting for the GPU to finish
+        // drawing it, then send it all again
+        glBindBuffer(GL_ARRAY_BUFFER, scene.particleVBOIDs[0]);
+        glBufferData(GL_ARRAY_BUFFER, count * sizeof(Particle), NULL,
+            GL_STREAM_DRAW);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(Particle),
+            scene.particles.data());
+        return glfwGetTime() - start;
+    }
+
+    // Read one buffer and capture the shader's outputs into the other.
+    // Nothing is rasterised; the points only exist to run the shader once
+    // per particle.
+    int target = 1 - scene.source;
+    glUseProgram(scene.updateProgramID);
+    glUniform1f(scene.dtID, dt);
+    glUniform1f(scene.timeID, scene.time);
+    glBindVertexArray(scene.vaoIDs[scene.source]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0,
+        scene.particleVBOIDs[target]);
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, count);
+    glEndTransformFeedback();
+    glDisable(GL_RASTERIZER_DISCARD);
+    // Unbind it, so it's not still bound for feedback while drawn from
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    scene.source = target;
+    return glfwGetTime() - start;
+}
+
+static void drawParticles() {
+    glm::mat4 projection = glm::perspective(
+        glm::radians(45.f), (float)sceneWidth / sceneHeight, 0.1f, 200.f);
+    glm::mat4 view = glm::lookAt(
+        glm::vec3(0, 12, 30), // In front of the fountain and a little above,
+        glm::vec3(0, 5, 0),   // looking at its middle
+        glm::vec3(0, 1, 0)
+    );
+    glm::mat4 vp = projection * view;
+
+    // Clear the screen
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    int count = particleCount();
+    glUseProgram(scene.drawProgramID);
+    glUniformMatrix4fv(scene.vpID, 1, GL_FALSE, &vp[0][0]);
+    glUniform1f(scene.pointScaleID, 60);
+    glUniform1f(scene.brightnessID, fminf(1, 16384.f / count));
+    // Straight from the buffer the update just wrote
+    glBindVertexArray(scene.vaoIDs[scene.source]);
+    glDrawArrays(GL_POINTS, 0, count);
+}
+
+static void printHeader() {
+    printf("%-6s %10s %14s %14s %10s %14s\n", "update", "particles",
+        "update cpu ms", "update gpu ms", "frame ms", "Mparticles/s");
+}
+
+static void printRow(UpdateMode mode, int count, const UpdateTotals &t) {
+    if (!t.frames)
+        return;
+    double n = t.frames, frame = t.frameSeconds / n;
+    printf("%-6s %10d %14.3f %14.3f %10.3f %14.1f\n", updateModeNames[mode],
+        count, t.updateSeconds * 1e3 / n,
+        t.gpuFrames ? t.gpuSeconds * 1e3 / t.gpuFrames : 0, frame * 1e3,
+        count / frame / 1e6);
+}
+
+static void printStats() {
+    puts("\nAverage per frame:");
+    printHeader();
+    for (int step = 0; step < countStepCount; step++)
+        for (int mode = 0; mode < UPDATE_MODE_COUNT; mode++)
+            printRow((UpdateMode)mode, countSteps[step],
+                scene.totals[mode][step]);
+
+    // How much faster the GPU path is at each size
+    for (int step = 0; step < countStepCount; step++) {
+        const UpdateTotals &cpu = scene.totals[UPDATE_CPU][step],
+                           &gpu = scene.totals[UPDATE_GPU][step];
+        if (cpu.frames && gpu.frames)
+            printf("%d particles: GPU frames take %.1f%% of CPU frames\n",
+                countSteps[step], 100 * (gpu.frameSeconds / gpu.frames)
+                / (cpu.frameSeconds / cpu.frames));
+    }
+}
+
+int main(int argc, char **argv) {
+    markMainStart();
+
+    bool bench = argc == 2 && !strcmp(argv[1], "bench");
+    if (argc > 1 && !bench) {
+        fputs("Usage: 13 [bench]\n"
+              "  bench draws a fixed number of frames for each particle\n"
+              "  count, updating on the CPU and then the GPU, then exits.\n"
+              "  Otherwise, C switches between CPU and GPU updates and +/-\n"
+              "  change the particle count while running.\n",
+              stderr);
+        return 1;
+    }
+
+    scene.mode = bench ? UPDATE_CPU : UPDATE_GPU;
+    scene.countStep = bench ? 0 : 2;
+
+    GLFWwindow *window;
+    init(&window);
+    printConfig();
+
+    // In bench mode, every step is the same length whatever the frame rate,
+    // and the first few frames after a switch aren't counted.
+    const unsigned benchFrames = 200, warmupFrames = 10;
+    const float benchStep = 1 / 60.f;
+    unsigned frame = 0, configFrame = 0;
+    int config = scene.mode * countStepCount + scene.countStep;
+    double lastTime = glfwGetTime(), lastReport = lastTime;
+
+    do {
+        // Real time, but not so much at once that particles jump
+        float dt = bench ? benchStep : fminf(glfwGetTime() - lastTime, 0.05f);
+        UpdateTotals totals = {};
+        totals.frames = 1;
+
+        beginGPUTimer(frame, configFrame >= warmupFrames ? config : -1);
+        totals.updateSeconds = update(dt);
+        glEndQuery(GL_TIME_ELAPSED);
+        drawParticles();
+
+        // Swap buffers
+        glfwSwapBuffers(window);
+        reportStartupTime();
+        glfwPollEvents();
+
+        double now = glfwGetTime();
+        totals.frameSeconds = now - lastTime;
+        lastTime = now;
+        if (configFrame >= warmupFrames) {
+            addTotals(scene.totals[config / countStepCount]
+                                  [config % countStepCount], totals);
+            addTotals(scene.window, totals);
+        }
+        frame++;
+        configFrame++;
+        int current = scene.mode * countStepCount + scene.countStep;
+        if (current != config) {
+            config = current;
+            configFrame = 0;
+        }
+
+        // CPU then GPU for each count, so each pair runs close together
+        if (bench && configFrame == warmupFrames + benchFrames) {
+            if (scene.mode == UPDATE_GPU
+                && scene.countStep + 1 == countStepCount)
+                break;
+            if (scene.mode == UPDATE_CPU)
+                scene.mode = UPDATE_GPU;
+            else {
+                scene.mode = UPDATE_CPU;
+                scene.countStep++;
+            }
+            config = scene.mode * countStepCount + scene.countStep;
+            configFrame = 0;
+            resetParticles();
+            printConfig();
+        }
+
+        if (!bench && now - lastReport >= 1) {
+            printHeader();
+            printRow(scene.mode, particleCount(), scene.window);
+            scene.window = {};
+            lastReport = now;
+        }
+
+        // Check if the ESC key was pressed or the window was closed
+    } while (glfwGetKey(window, GLFW_KEY_ESCAPE) != GLFW_PRESS &&
+             !glfwWindowShouldClose(window));
+
+    printStats();
+
+    // Close OpenGL window and terminate GLFW
+    glfwTerminate();
+
+    return 0;
+}
@@ -0,0 +1,12 @@
+#version 330 core
+
+// Interpolated values from the vertex shaders
+in vec3 fragmentColor;
+
+// Output data
+out vec4 color;
+
+void main() {
+    // Added to what's there already; see the blend function
+    color = vec4(fragmentColor, 1);
+}
@@ -0,0 +1,62 @@
+#version 330 core
+
+// A particle as of the last step: its position and age, then its velocity
+// and lifetime, in seconds.
+layout(location = 0) in vec4 positionAge;
+layout(location = 1) in vec4 velocityLifetime;
+
+// The particle after this step, captured by transform feedback into the
+// other buffer. Nothing is drawn.
+out vec4 nextPositionAge;
+out vec4 nextVelocityLifetime;
+
+// Seconds since the last step, and since the start
+uniform float dt;
+uniform float time;
+
+// Integer hash; the CPU path in 13.cpp does the same
+uint hash(uint x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// 0 to 1
+float random(uint seed) {
+    return float(hash(seed) >> 8) / 16777216.0;
+}
+
+void main() {
+    vec3 position = positionAge.xyz, velocity = velocityLifetime.xyz;
+    float age = positionAge.w + dt, lifetime = velocityLifetime.w;
+
+    if (age >= lifetime) {
+        // Start again from the fountain, in a cone pointing up
+        uint seed = hash(uint(gl_VertexID) ^ floatBitsToUint(time));
+        float angle = 6.2831853 * random(seed),
+              spread = 0.3 * random(seed + 1u),
+              speed = 8 + 4 * random(seed + 2u);
+        position = vec3(0);
+        velocity = vec3(cos(angle) * spread, 1, sin(angle) * spread) * speed;
+        age = 0;
+        lifetime = 2 + 3 * random(seed + 3u);
+    } else {
+        // Gravity, a swirl round the fountain, and a little drag
+        vec3 acceleration = vec3(0, -9.8, 0)
+                          + 1.5 * vec3(-position.z, 0, position.x);
+        velocity += acceleration * dt;
+        velocity *= 1 - 0.1 * dt;
+        position += velocity * dt;
+        // Bounce off the ground, losing half the speed
+        if (position.y < 0) {
+            position.y = -position.y;
+            velocity.y *= -0.5;
+        }
+    }
+
+    nextPositionAge = vec4(position, age);
+    nextVelocityLifetime = vec4(velocity, lifetime);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+// Input vertex data: the particle state written by the update, read straight
+// from the same buffer.
+layout(location = 0) in vec4 positionAge;
+layout(location = 1) in vec4 velocityLifetime;
+
+// Output data; the same for every fragment of the point.
+out vec3 fragmentColor;
+
+uniform mat4 VP;
+// Size in pixels of a point one unit from the camera
+uniform float pointScale;
+// Scales every colour, so that many particles adding up don't all saturate
+uniform float brightness;
+
+void main() {
+    gl_Position = VP * vec4(positionAge.xyz, 1);
+    gl_PointSize = clamp(pointScale / gl_Position.w, 1, 8);
+
+    // White hot when new, cooling to dark red
+    float life = clamp(positionAge.w / velocityLifetime.w, 0, 1);
+    fragmentColor = mix(vec3(1, 0.8, 0.3), vec3(0.6, 0.1, 0.05), life)
+                  * (1 - life) * brightness;
+}
@@ -0,0 +1,210 @@
+#ifndef COMMAND_BUFFER_HPP
+#define COMMAND_BUFFER_HPP
+
+// Command buffers, so that draws can be prepared on any thread while only the
+// thread that owns the GL context talks to GL.
+//
+// Each recording thread has its own CommandBuffer and fills it with small
+// packets: bind this program, update that buffer range, draw. Packets are
+// recorded in groups; each group has a sort key and its packets run together,
+// in the order they were recorded. Once every thread is done,
+// mergeCommandBuffers() gathers all the groups and sorts them by key, and the
+// render thread executes them.
+//
+// Nothing here knows about GL. Programs, buffers and so on are 32-bit handles
+// that only the executor gives a meaning to, so the same recording code could
+// drive another API.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "memory.hpp"
+
+enum CommandType: uint8_t {
+    CMD_BIND_PROGRAM,
+    CMD_BIND_VERTEX_ARRAY,
+    // Per-instance data for the draws that follow starts at offset in buffer
+    CMD_BIND_INSTANCES,
+    CMD_SET_MATRIX,
+    CMD_UPDATE_BUFFER,
+    CMD_DRAW,
+};
+
+struct Command {
+    CommandType type;
+    union {
+        struct {
+            uint32_t program;
+        } bindProgram;
+        struct {
+            uint32_t vertexArray;
+        } bindVertexArray;
+        struct {
+            uint32_t buffer, offset;
+        } bindInstances;
+        struct {
+            int32_t uniform;
+            const float *value; // 16 floats, column-major
+        } setMatrix;
+        struct {
+            uint32_t buffer, offset, size;
+            const void *data;
+        } updateBuffer;
+        struct {
+            uint32_t first, count, instanceCount;
+        } draw;
+    };
+};
+
+// A group of commands, as merged from all the buffers
+struct CommandRun {
+    uint64_t key;
+    // Which buffer and group this was, to break ties the same way every time
+    uint32_t buffer, group;
+    const Command *commands;
+    uint32_t count;
+};
+
+class CommandBuffer {
+public:
+    // Space for up to maxCommands commands in maxGroups groups, and dataBytes
+    // of data for them to point to. Running out is fatal, as for FrameArena.
+    CommandBuffer(size_t maxCommands, size_t maxGroups, size_t dataBytes):
+        data(dataBytes),
+        commands((Command*)malloc(maxCommands * sizeof(Command))),
+        groups((Group*)malloc(maxGroups * sizeof(Group))),
+        maxCommands(maxCommands), maxGroups(maxGroups) {
+        if (!commands || !groups) {
+            perror("Failed to allocate command buffer");
+            exit(1);
+        }
+    }
+    ~CommandBuffer() {
+        free(commands);
+        free(groups);
+    }
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer &operator=(const CommandBuffer&) = delete;
+
+    // Forget last frame's commands and data. The executor must be done with
+    // them.
+    void reset() {
+        data.reset();
+        commandCount = groupCount = 0;
+    }
+
+    // Start a group. Commands up to the next begin() run in order, at the
+    // place key sorts to.
+    void begin(uint64_t key) {
+        if (groupCount == maxGroups) {
+            fprintf(stderr, "Command buffer out of groups (%zu)\n", maxGroups);
+            exit(1);
+        }
+        groups[groupCount++] = {key, commandCount};
+    }
+
+    void bindProgram(uint32_t program) {
+        add(CMD_BIND_PROGRAM).bindProgram = {program};
+    }
+    void bindVertexArray(uint32_t vertexArray) {
+        add(CMD_BIND_VERTEX_ARRAY).bindVertexArray = {vertexArray};
+    }
+    void bindInstances(uint32_t buffer, uint32_t offset) {
+        add(CMD_BIND_INSTANCES).bindInstances = {buffer, offset};
+    }
+    // value is copied
+    void setMatrix(int32_t uniform, const float *value) {
+        float *copy = allocate<float>(16);
+        memcpy(copy, value, 16 * sizeof(float));
+        add(CMD_SET_MATRIX).setMatrix = {uniform, copy};
+    }
+    // source must stay valid until the next reset(); allocate() it from here
+    // to make sure.
+    void updateBuffer(uint32_t buffer, uint32_t offset, uint32_t size,
+                      const void *source) {
+        add(CMD_UPDATE_BUFFER).updateBuffer = {buffer, offset, size, source};
+    }
+    void draw(uint32_t first, uint32_t count, uint32_t instanceCount) {
+        add(CMD_DRAW).draw = {first, count, instanceCount};
+    }
+
+    // Space for n Ts that lasts until the next reset(), for commands to
+    // point at
+    template <typename T>
+    T *allocate(size_t n) {
+        return (T*)data.allocate(n * sizeof(T), alignof(T));
+    }
+
+    size_t commandsRecorded() const {
+        return commandCount;
+    }
+    size_t groupsRecorded() const {
+        return groupCount;
+    }
+    size_t dataBytesUsed() const {
+        return data.bytesUsed();
+    }
+
+private:
+    struct Group {
+        uint64_t key;
+        size_t first;
+    };
+
+    Command &add(CommandType type) {
+        if (!groupCount) {
+            fputs("Command recorded before CommandBuffer::begin()\n", stderr);
+            exit(1);
+        }
+        if (commandCount == maxCommands) {
+            fprintf(stderr, "Command buffer out of commands (%zu)\n",
+                maxCommands);
+            exit(1);
+        }
+        Command &command = commands[commandCount++];
+        command.type = type;
+        return command;
+    }
+
+    FrameArena data;
+    Command *commands;
+    Group *groups;
+    size_t maxCommands, maxGroups;
+    size_t commandCount = 0, groupCount = 0;
+
+    friend void mergeCommandBuffers(CommandBuffer *const *, int,
+                                    FrameVector<CommandRun>&);
+};
+
+// Gather the groups from count buffers into runs, sorted by key. Equal keys
+// keep buffer order, then recording order, so the result doesn't depend on
+// which thread finished first. Reserve runs for every group beforehand.
+inline void mergeCommandBuffers(CommandBuffer *const *buffers, int count,
+                                FrameVector<CommandRun> &runs) {
+    runs.clear();
+    for (int b = 0; b < count; b++) {
+        const CommandBuffer &buffer = *buffers[b];
+        for (size_t g = 0; g < buffer.groupCount; g++) {
+            size_t first = buffer.groups[g].first,
+                   end = g + 1 < buffer.groupCount
+                       ? buffer.groups[g + 1].first : buffer.commandCount;
+            runs.push_back({buffer.groups[g].key, (uint32_t)b, (uint32_t)g,
+                buffer.commands + first, (uint32_t)(end - first)});
+        }
+    }
+    std::sort(runs.begin(), runs.end(),
+        [](const CommandRun &a, const CommandRun &b) {
+            if (a.key != b.key)
+                return a.key < b.key;
+            if (a.buffer != b.buffer)
+                return a.buffer < b.buffer;
+            return a.group < b.group;
+        });
+}
+
+#endif
@@ -0,0 +1,98 @@
+// Build tool: writes a C header to stdout that embeds the given shader files
+// as string literals, along with hashes of their names and contents. Each
+// tutorial's makefile runs it to make shaders.h; see embedded-shaders.h.
+//
+// Usage: embed-shaders file.glsl... > shaders.h
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "embedded-shaders.h"
+
+static char *readFile(const char *fn, int *size) {
+    FILE *f = fopen(fn, "rb");
+    if (!f) {
+        perror(fn);
+        exit(1);
+    }
+    if (fseek(f, 0, SEEK_END)) {
+        perror("Failed to get file size");
+        exit(1);
+    }
+    long length = ftell(f);
+    if (length == -1) {
+        perror("Failed to get file size");
+        exit(1);
+    }
+    rewind(f);
+    char *contents = (char*)malloc(length + 1);
+    if (!contents) {
+        perror("Failed to allocate file memory");
+        exit(1);
+    }
+    if (fread(contents, 1, length, f) != (size_t)length) {
+        perror("Failed to read file");
+        exit(1);
+    }
+    fclose(f);
+    contents[length] = '\0';
+    *size = (int)length;
+    return contents;
+}
+
+// Write the source as a string literal, one line of source per line of output.
+static void writeLiteral(const char *source, int size) {
+    fputs("        \"", stdout);
+    for (int i = 0; i < size; i++) {
+        char c = source[i];
+        switch (c) {
+        case '\\': fputs("\\\\", stdout); break;
+        case '"':  fputs("\\\"", stdout); break;
+        case '\t': fputs("\\t", stdout); break;
+        case '\r': fputs("\\r", stdout); break;
+        case '\n':
+            fputs("\\n\"", stdout);
+            if (i + 1 < size)
+                fputs("\n        \"", stdout);
+            continue;
+        default:
+            putchar(c);
+        }
+    }
+    if (size && source[size - 1] != '\n')
+        putchar('"');
+    if (!size)
+        putchar('"');
+    putchar('\n');
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fputs("Usage: embed-shaders file.glsl... > shaders.h\n", stderr);
+        return 1;
+    }
+
+    puts("// Generated by ../common/embed-shaders from this directory's shaders.");
+    puts("// Don't edit this; edit the .glsl files and rebuild.");
+    puts("");
+    puts("#include \"../common/embedded-shaders.h\"");
+    puts("");
+    puts("EMBEDDED_DATA struct EmbeddedShader embeddedShaders[] = {");
+    for (int i = 1; i < argc; i++) {
+        const char *name = strrchr(argv[i], '/');
+        name = name ? name + 1 : argv[i];
+        int size;
+        char *source = readFile(argv[i], &size);
+
+        printf("    {\n        \"%s\", 0x%08Xu, 0x%08Xu, %d,\n", name,
+            shaderHash(name, (int)strlen(name)), shaderHash(source, size),
+            size);
+        writeLiteral(source, size);
+        puts("    },");
+        free(source);
+    }
+    puts("};");
+    printf("EMBEDDED_DATA int embeddedShaderCount = %d;\n", argc - 1);
+    return 0;
+}
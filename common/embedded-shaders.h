@@ -0,0 +1,135 @@
+#ifndef EMBEDDED_SHADERS_H
+#define EMBEDDED_SHADERS_H
+
+// Shader sources compiled into the program. Each tutorial's makefile runs
+// embed-shaders over its .glsl files to generate shaders.h, which includes
+// this and defines embeddedShaders[] and embeddedShaderCount. Works from both
+// C and C++; in C++ the table and lookups are constexpr.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __cplusplus
+#define EMBEDDED_DATA constexpr
+#define EMBEDDED_FUNCTION constexpr
+#else
+#define EMBEDDED_DATA static const
+#define EMBEDDED_FUNCTION static inline
+#endif
+
+struct EmbeddedShader {
+    // File name, without any directory
+    const char *name;
+    // shaderHash() of the name, which lookups compare before the name itself
+    uint32_t nameHash;
+    // shaderHash() of the source, to key anything compiled from it
+    uint32_t sourceHash;
+    int size;
+    const char *source;
+};
+
+// 32-bit FNV-1a. embed-shaders uses the same function, so hashes computed
+// here match the ones in the generated table.
+EMBEDDED_FUNCTION uint32_t shaderHash(const char *s, int size) {
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < size; i++) {
+        hash ^= (unsigned char)s[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+EMBEDDED_FUNCTION int shaderNameLength(const char *name) {
+    int length = 0;
+    while (name[length])
+        length++;
+    return length;
+}
+
+// The embedded shader with the given file name, or NULL
+EMBEDDED_FUNCTION const struct EmbeddedShader *findEmbeddedShader(
+        const struct EmbeddedShader *shaders, int count, const char *name) {
+    int length = shaderNameLength(name);
+    uint32_t hash = shaderHash(name, length);
+    for (int i = 0; i < count; i++) {
+        if (shaders[i].nameHash != hash)
+            continue;
+        int c = 0;
+        while (c <= length && shaders[i].name[c] == name[c])
+            c++;
+        if (c > length)
+            return &shaders[i];
+    }
+    return NULL;
+}
+
+// Read a shader from disk. Returns memory the caller must free.
+static inline char *readShaderFile(const char *dir, const char *fn,
+                                   int *size) {
+    char *path = (char*)malloc(strlen(dir) + strlen(fn) + 2);
+    if (!path) {
+        perror("Failed to allocate shader path");
+        exit(1);
+    }
+    sprintf(path, "%s/%s", dir, fn);
+
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror("Failed to load shader file");
+        exit(1);
+    }
+    free(path);
+    if (fseek(f, 0, SEEK_END)) {
+        perror("Failed to get file size");
+        exit(1);
+    }
+    long length = ftell(f);
+    if (length == -1) {
+        perror("Failed to get file size");
+        exit(1);
+    }
+    rewind(f);
+    char *source = (char*)malloc(length);
+    if (!source) {
+        perror("Failed to allocate source memory");
+        exit(1);
+    }
+    if (fread(source, 1, length, f) != (size_t)length) {
+        perror("Failed to read file");
+        exit(1);
+    }
+    if (fclose(f))
+        perror("Warning: failed to close source file");
+
+    *size = (int)length;
+    return source;
+}
+
+// The source of the named shader. Normally that's the copy embedded at build
+// time, so nothing is read at startup and the program runs from any directory.
+// During development, set SHADER_DIR to read shaders from that directory
+// instead, so they can be edited without rebuilding; then *allocated is set to
+// memory the caller must free. Otherwise it's set to NULL.
+static inline const char *shaderSource(const struct EmbeddedShader *shaders,
+                                       int count, const char *fn, int *size,
+                                       char **allocated) {
+    const char *dir = getenv("SHADER_DIR");
+    if (dir && *dir) {
+        *allocated = readShaderFile(dir, fn, size);
+        return *allocated;
+    }
+
+    *allocated = NULL;
+    const struct EmbeddedShader *shader = findEmbeddedShader(shaders, count,
+        fn);
+    if (!shader) {
+        fprintf(stderr, "No embedded shader '%s'\n", fn);
+        exit(1);
+    }
+    *size = shader->size;
+    return shader->source;
+}
+
+#endif
@@ -0,0 +1,280 @@
+#ifndef GEOMETRY_STORE_HPP
+#define GEOMETRY_STORE_HPP
+
+// Geometry that changes a little at a time. A GeometryStore keeps a GL buffer
+// and a copy of it in memory. Features get ranges of the buffer from a
+// free-list sub-allocator, so they can grow, shrink, come and go. Writes go
+// to the copy and mark their range dirty. Each frame, upload() merges the
+// dirty ranges and sends only those bytes, so an edit costs what it changed
+// rather than the size of the buffer.
+//
+// This makes GL calls, so for them to be traced include it after
+// gltrace.h.
+
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+struct ByteRange {
+    size_t offset, size;
+
+    size_t end() const {
+        return offset + size;
+    }
+};
+
+// Hands out ranges of a buffer first-fit, from a free list sorted by offset.
+// Freed ranges merge with free neighbours, so holes don't splinter.
+class RangeAllocator {
+public:
+    static const size_t npos = (size_t)-1;
+
+    explicit RangeAllocator(size_t capacity): capacity(capacity) {
+        if (capacity)
+            freeList.push_back({0, capacity});
+    }
+
+    // Returns the offset of size free bytes, or npos if no hole is that big
+    size_t allocate(size_t size) {
+        for (size_t i = 0; i < freeList.size(); i++) {
+            ByteRange &hole = freeList[i];
+            if (hole.size < size)
+                continue;
+            size_t offset = hole.offset;
+            hole.offset += size;
+            hole.size -= size;
+            if (!hole.size)
+                freeList.erase(freeList.begin() + i);
+            return offset;
+        }
+        return npos;
+    }
+
+    void free(size_t offset, size_t size) {
+        if (!size)
+            return;
+        auto next = std::lower_bound(freeList.begin(), freeList.end(), offset,
+            [](const ByteRange &r, size_t offset) {
+                return r.offset < offset;
+            });
+        // Join the hole before, the hole after, or both
+        bool joinsPrev = next != freeList.begin()
+                         && (next - 1)->end() == offset,
+             joinsNext = next != freeList.end()
+                         && next->offset == offset + size;
+        if (joinsPrev && joinsNext) {
+            (next - 1)->size += size + next->size;
+            freeList.erase(next);
+        } else if (joinsPrev)
+            (next - 1)->size += size;
+        else if (joinsNext) {
+            next->offset = offset;
+            next->size += size;
+        } else
+            freeList.insert(next, {offset, size});
+    }
+
+    // Add space at the end
+    void grow(size_t newCapacity) {
+        size_t old = capacity;
+        capacity = newCapacity;
+        free(old, newCapacity - old);
+    }
+
+    // One past the last byte in use; nothing beyond needs drawing
+    size_t end() const {
+        if (!freeList.empty() && freeList.back().end() == capacity)
+            return freeList.back().offset;
+        return capacity;
+    }
+
+    size_t freeBytes() const {
+        size_t total = 0;
+        for (const ByteRange &hole: freeList)
+            total += hole.size;
+        return total;
+    }
+    size_t holeCount() const {
+        return freeList.size();
+    }
+    size_t bytesCapacity() const {
+        return capacity;
+    }
+
+private:
+    std::vector<ByteRange> freeList;
+    size_t capacity;
+};
+
+enum UploadMode {
+    // Respecify the whole buffer every frame, as if nothing were tracked
+    UPLOAD_WHOLE,
+    // glBufferSubData for each merged dirty range
+    UPLOAD_SUB_DATA,
+    // Map each merged dirty range, write it and unmap it
+    UPLOAD_MAP_RANGE,
+    UPLOAD_MODE_COUNT
+};
+
+static const char *const uploadModeNames[UPLOAD_MODE_COUNT] = {
+    "whole buffer", "sub data", "map range"
+};
+
+struct UploadStats {
+    size_t bytes, calls;
+    // Ranges written since the last upload, and what they merged into
+    size_t rangesMarked, rangesUploaded;
+};
+
+class GeometryStore {
+public:
+    // Dirty ranges closer together than mergeGap bytes are sent as one, since
+    // each call costs more than a few extra bytes.
+    GeometryStore(GLenum target, size_t capacity, size_t mergeGap = 256):
+        target(target), mergeGap(mergeGap), shadow(capacity),
+        allocator(capacity) {
+        glGenBuffers(1, &bufferID);
+        glBindBuffer(target, bufferID);
+        glBufferData(target, capacity, NULL, GL_DYNAMIC_DRAW);
+        respecify = true;
+    }
+    ~GeometryStore() {
+        glDeleteBuffers(1, &bufferID);
+    }
+    GeometryStore(const GeometryStore&) = delete;
+    GeometryStore &operator=(const GeometryStore&) = delete;
+
+    GLuint buffer() const {
+        return bufferID;
+    }
+
+    // Space for size bytes, growing the buffer if no hole is big enough.
+    // Its contents are undefined until written.
+    size_t allocate(size_t size) {
+        size_t offset = allocator.allocate(size);
+        if (offset != RangeAllocator::npos)
+            return offset;
+
+        size_t capacity = allocator.bytesCapacity();
+        do
+            capacity = capacity ? capacity * 2 : 65536;
+        while (allocator.end() + size > capacity);
+        allocator.grow(capacity);
+        shadow.resize(capacity);
+        // The whole buffer has to be made again at the new size
+        respecify = true;
+        return allocator.allocate(size);
+    }
+
+    void release(size_t offset, size_t size) {
+        allocator.free(offset, size);
+    }
+
+    void write(size_t offset, const void *data, size_t size) {
+        memcpy(shadow.data() + offset, data, size);
+        markDirty(offset, size);
+    }
+    // Zero a range, such as one about to be released, so that what was there
+    // stops being drawn
+    void clear(size_t offset, size_t size) {
+        memset(shadow.data() + offset, 0, size);
+        markDirty(offset, size);
+    }
+
+    // For writing in place: the memory copy of the range starting at offset.
+    // Call markDirty() for whatever is written.
+    unsigned char *data(size_t offset) {
+        return shadow.data() + offset;
+    }
+    void markDirty(size_t offset, size_t size) {
+        if (size)
+            dirty.push_back({offset, size});
+    }
+
+    // Send what changed since the last upload. Leaves the buffer bound.
+    UploadStats upload(UploadMode mode) {
+        UploadStats stats = {};
+        stats.rangesMarked = dirty.size();
+        glBindBuffer(target, bufferID);
+
+        if (respecify || mode == UPLOAD_WHOLE) {
+            glBufferData(target, shadow.size(), shadow.data(),
+                GL_DYNAMIC_DRAW);
+            stats.bytes = shadow.size();
+            stats.calls = stats.rangesUploaded = 1;
+            dirty.clear();
+            respecify = false;
+            return stats;
+        }
+
+        mergeDirty();
+        for (const ByteRange &range: dirty) {
+            const unsigned char *source = shadow.data() + range.offset;
+            if (mode == UPLOAD_SUB_DATA)
+                glBufferSubData(target, range.offset, range.size, source);
+            else {
+                // Only the range is invalidated, so the driver needn't keep
+                // its old contents or wait for draws that don't touch it
+                void *mapped = glMapBufferRange(target, range.offset,
+                    range.size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+                if (!mapped) {
+                    fputs("Failed to map geometry buffer\n", stderr);
+                    exit(1);
+                }
+                memcpy(mapped, source, range.size);
+                // The contents can be lost, for example on a mode switch;
+                // if so, send everything next time
+                if (!glUnmapBuffer(target))
+                    respecify = true;
+            }
+            stats.bytes += range.size;
+            stats.calls++;
+        }
+        stats.rangesUploaded = dirty.size();
+        dirty.clear();
+        return stats;
+    }
+
+    // Bytes from the start of the buffer to the end of the last range in use
+    size_t bytesInUse() const {
+        return allocator.end();
+    }
+    const RangeAllocator &ranges() const {
+        return allocator;
+    }
+
+private:
+    // Sort the dirty ranges and join those that overlap or nearly touch
+    void mergeDirty() {
+        if (dirty.empty())
+            return;
+        std::sort(dirty.begin(), dirty.end(),
+            [](const ByteRange &a, const ByteRange &b) {
+                return a.offset < b.offset;
+            });
+        size_t merged = 0;
+        for (size_t i = 1; i < dirty.size(); i++) {
+            ByteRange &last = dirty[merged];
+            if (dirty[i].offset <= last.end() + mergeGap) {
+                if (dirty[i].end() > last.end())
+                    last.size = dirty[i].end() - last.offset;
+            } else
+                dirty[++merged] = dirty[i];
+        }
+        dirty.resize(merged + 1);
+    }
+
+    GLenum target;
+    GLuint bufferID;
+    size_t mergeGap;
+    std::vector<unsigned char> shadow;
+    std::vector<ByteRange> dirty;
+    RangeAllocator allocator;
+    bool respecify;
+};
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef GLTRACE_FORMAT_H
+#define GLTRACE_FORMAT_H
+
+// The layout of a GL trace file, shared by the recorder (gltrace.c) and the
+// replayer (../replay).
+//
+// A trace starts with the 4 bytes "GLTR" and a format version byte. Then
+// come the records, one per call:
+//
+//     opcode     1 byte, a TraceOp
+//     argc       1 byte
+//     args       argc varints
+//     size       varint
+//     payload    size bytes
+//
+// Varints are unsigned LEB128: 7 bits per byte, least significant first, with
+// the top bit set on every byte but the last. Signed arguments are stored as
+// their 64-bit two's complement, and floats as their 32-bit pattern.
+// Arguments are in the order the GL function takes them, followed by its
+// return value if it has one. Object names are the ones the recording
+// program was given; the replayer maps them to its own. Data the call reads
+// from memory (buffer contents, shader source, uniform values, names written
+// by glGen*) is the payload, in the recording machine's byte order.
+//
+// A buffer mapping for writing is recorded when it's unmapped, as one
+// MAP_BUFFER_RANGE record holding the whole range as the program left it;
+// replaying it maps, copies and unmaps.
+
+#define GLTRACE_MAGIC "GLTR"
+// Only bumped when the layout changes so that older traces can't be read.
+// Adding ops doesn't: an older replayer just rejects the ones it lacks.
+#define GLTRACE_VERSION 1
+
+// Every call that can be recorded, in opcode order. SWAP_BUFFERS marks the
+// end of a frame. Opcodes never change, so new ops go on the end: those from
+// DELETE_BUFFERS on came after the first version.
+#define GLTRACE_OPS(X) \
+    X(WINDOW_HINT) \
+    X(CREATE_WINDOW) \
+    X(SWAP_BUFFERS) \
+    X(ACTIVE_TEXTURE) \
+    X(ATTACH_SHADER) \
+    X(BEGIN_QUERY) \
+    X(BIND_BUFFER) \
+    X(BIND_FRAMEBUFFER) \
+    X(BIND_RENDERBUFFER) \
+    X(BIND_TEXTURE) \
+    X(BIND_VERTEX_ARRAY) \
+    X(BLEND_FUNC) \
+    X(BLIT_FRAMEBUFFER) \
+    X(BUFFER_DATA) \
+    X(BUFFER_SUB_DATA) \
+    X(CHECK_FRAMEBUFFER_STATUS) \
+    X(CLEAR) \
+    X(CLEAR_COLOR) \
+    X(COLOR_MASK) \
+    X(COMPILE_SHADER) \
+    X(CREATE_PROGRAM) \
+    X(CREATE_SHADER) \
+    X(DELETE_FRAMEBUFFERS) \
+    X(DELETE_PROGRAM) \
+    X(DELETE_RENDERBUFFERS) \
+    X(DELETE_SHADER) \
+    X(DELETE_TEXTURES) \
+    X(DEPTH_FUNC) \
+    X(DEPTH_MASK) \
+    X(DETACH_SHADER) \
+    X(DISABLE) \
+    X(DRAW_ARRAYS) \
+    X(DRAW_ARRAYS_INSTANCED) \
+    X(ENABLE) \
+    X(ENABLE_VERTEX_ATTRIB_ARRAY) \
+    X(END_QUERY) \
+    X(FRAMEBUFFER_RENDERBUFFER) \
+    X(FRAMEBUFFER_TEXTURE_2D) \
+    X(GEN_BUFFERS) \
+    X(GEN_FRAMEBUFFERS) \
+    X(GEN_QUERIES) \
+    X(GEN_RENDERBUFFERS) \
+    X(GEN_TEXTURES) \
+    X(GEN_VERTEX_ARRAYS) \
+    X(GET_INTEGERV) \
+    X(GET_PROGRAM_INFO_LOG) \
+    X(GET_PROGRAMIV) \
+    X(GET_QUERY_OBJECTUI64V) \
+    X(GET_SHADER_INFO_LOG) \
+    X(GET_SHADERIV) \
+    X(GET_UNIFORM_LOCATION) \
+    X(LINK_PROGRAM) \
+    X(RENDERBUFFER_STORAGE_MULTISAMPLE) \
+    X(SHADER_SOURCE) \
+    X(TEX_IMAGE_2D) \
+    X(TEX_PARAMETERI) \
+    X(UNIFORM_1F) \
+    X(UNIFORM_1I) \
+    X(UNIFORM_2F) \
+    X(UNIFORM_3FV) \
+    X(UNIFORM_MATRIX_4FV) \
+    X(USE_PROGRAM) \
+    X(VERTEX_ATTRIB_DIVISOR) \
+    X(VERTEX_ATTRIB_POINTER) \
+    X(VIEWPORT) \
+    X(DELETE_BUFFERS) \
+    X(MAP_BUFFER_RANGE) \
+    X(DRAW_ELEMENTS_INSTANCED) \
+    X(BEGIN_TRANSFORM_FEEDBACK) \
+    X(BIND_BUFFER_BASE) \
+    X(END_TRANSFORM_FEEDBACK) \
+    X(TRANSFORM_FEEDBACK_VARYINGS)
+
+#define GLTRACE_ENUM(name) TRACE_##name,
+enum TraceOp {
+    GLTRACE_OPS(GLTRACE_ENUM)
+    TRACE_OP_COUNT
+};
+#undef GLTRACE_ENUM
+
+// The most arguments any record has
+#define GLTRACE_MAX_ARGS 10
+
+#endif
@@ -0,0 +1,625 @@
+// The GL call recorder; see gltrace.h for how it's hooked up, and
+// gltrace-format.h for what it writes.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#define GLTRACE_IMPLEMENTATION
+#include "gltrace.h"
+#include "gltrace-format.h"
+
+// The trace being written, or NULL if GL_TRACE isn't set. Opened on the first
+// call, since that's before anything else can happen.
+static FILE *traceFile;
+static bool traceChecked;
+static uint64_t traceFrame;
+
+// Buffers mapped while recording, recorded once they're unmapped. A mapping
+// for writing may well not be readable, so the program is given a copy to
+// write to instead, which goes into both the trace and the real mapping when
+// it's unmapped.
+#define GLTRACE_MAX_MAPPINGS 8
+struct TraceMapping {
+    GLenum target;
+    GLintptr offset;
+    GLsizeiptr length;
+    GLbitfield access;
+    void *pointer, *shadow;
+};
+static struct TraceMapping traceMappings[GLTRACE_MAX_MAPPINGS];
+static int traceMappingCount;
+
+static void closeTrace(void) {
+    if (fclose(traceFile))
+        perror("Warning: failed to finish GL trace");
+    traceFile = NULL;
+}
+
+static FILE *recording(void) {
+    if (traceChecked)
+        return traceFile;
+    traceChecked = true;
+
+    const char *fn = getenv("GL_TRACE");
+    if (!fn || !*fn)
+        return NULL;
+    traceFile = fopen(fn, "wb");
+    if (!traceFile) {
+        perror("Failed to open GL trace");
+        exit(1);
+    }
+    // Records are small and many; don't make a system call for each
+    setvbuf(traceFile, NULL, _IOFBF, 1 << 20);
+    fputs(GLTRACE_MAGIC, traceFile);
+    putc(GLTRACE_VERSION, traceFile);
+    atexit(closeTrace);
+    printf("Recording GL calls to '%s'\n", fn);
+    return traceFile;
+}
+
+static void putVarint(uint64_t value) {
+    while (value >= 0x80) {
+        putc((int)(value & 0x7F) | 0x80, traceFile);
+        value >>= 7;
+    }
+    putc((int)value, traceFile);
+}
+
+static void writeRecord(enum TraceOp op, const void *payload, size_t size,
+                        int argc, const uint64_t *args) {
+    putc(op, traceFile);
+    putc(argc, traceFile);
+    for (int i = 0; i < argc; i++)
+        putVarint(args[i]);
+    putVarint(size);
+    if (size && fwrite(payload, 1, size, traceFile) != size) {
+        perror("Failed to write GL trace");
+        exit(1);
+    }
+}
+
+// Record a call, if recording. The arguments are cast to uint64_t, so signed
+// ones are stored as their two's complement.
+#define RECORD(op, payload, size, ...) do { \
+        if (recording()) { \
+            const uint64_t args[] = {__VA_ARGS__}; \
+            writeRecord(TRACE_##op, payload, size, \
+                sizeof(args) / sizeof(args[0]), args); \
+        } \
+    } while (0)
+
+#define S(value) ((uint64_t)(int64_t)(value))
+
+static uint64_t floatBits(GLfloat value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+// Size of the pixels glTexImage2D will read, assuming the default unpack
+// alignment of 4. Returns 0 for formats the recorder doesn't know.
+static size_t imageSize(GLsizei width, GLsizei height, GLenum format,
+                        GLenum type) {
+    size_t channels;
+    switch (format) {
+    case GL_RED:  channels = 1; break;
+    case GL_RG:   channels = 2; break;
+    case GL_RGB:  channels = 3; break;
+    case GL_RGBA: channels = 4; break;
+    default: return 0;
+    }
+    size_t channelBytes;
+    switch (type) {
+    case GL_UNSIGNED_BYTE: channelBytes = 1; break;
+    case GL_FLOAT:         channelBytes = 4; break;
+    default: return 0;
+    }
+    size_t rowBytes = (width * channels * channelBytes + 3) & ~(size_t)3;
+    return rowBytes * height;
+}
+
+void traceWindowHint(int hint, int value) {
+    RECORD(WINDOW_HINT, NULL, 0, S(hint), S(value));
+    glfwWindowHint(hint, value);
+}
+
+GLFWwindow *traceCreateWindow(int width, int height, const char *title,
+                              GLFWmonitor *monitor, GLFWwindow *share) {
+    RECORD(CREATE_WINDOW, NULL, 0, S(width), S(height));
+    return glfwCreateWindow(width, height, title, monitor, share);
+}
+
+void traceSwapBuffers(GLFWwindow *window) {
+    RECORD(SWAP_BUFFERS, NULL, 0, traceFrame++);
+    glfwSwapBuffers(window);
+}
+
+void traceActiveTexture(GLenum texture) {
+    RECORD(ACTIVE_TEXTURE, NULL, 0, texture);
+    glActiveTexture(texture);
+}
+
+void traceAttachShader(GLuint program, GLuint shader) {
+    RECORD(ATTACH_SHADER, NULL, 0, program, shader);
+    glAttachShader(program, shader);
+}
+
+void traceBeginQuery(GLenum target, GLuint id) {
+    RECORD(BEGIN_QUERY, NULL, 0, target, id);
+    glBeginQuery(target, id);
+}
+
+void traceBeginTransformFeedback(GLenum primitiveMode) {
+    RECORD(BEGIN_TRANSFORM_FEEDBACK, NULL, 0, primitiveMode);
+    glBeginTransformFeedback(primitiveMode);
+}
+
+void traceBindBuffer(GLenum target, GLuint buffer) {
+    RECORD(BIND_BUFFER, NULL, 0, target, buffer);
+    glBindBuffer(target, buffer);
+}
+
+void traceBindBufferBase(GLenum target, GLuint index, GLuint buffer) {
+    RECORD(BIND_BUFFER_BASE, NULL, 0, target, index, buffer);
+    glBindBufferBase(target, index, buffer);
+}
+
+void traceBindFramebuffer(GLenum target, GLuint framebuffer) {
+    RECORD(BIND_FRAMEBUFFER, NULL, 0, target, framebuffer);
+    glBindFramebuffer(target, framebuffer);
+}
+
+void traceBindRenderbuffer(GLenum target, GLuint renderbuffer) {
+    RECORD(BIND_RENDERBUFFER, NULL, 0, target, renderbuffer);
+    glBindRenderbuffer(target, renderbuffer);
+}
+
+void traceBindTexture(GLenum target, GLuint texture) {
+    RECORD(BIND_TEXTURE, NULL, 0, target, texture);
+    glBindTexture(target, texture);
+}
+
+void traceBindVertexArray(GLuint array) {
+    RECORD(BIND_VERTEX_ARRAY, NULL, 0, array);
+    glBindVertexArray(array);
+}
+
+void traceBlendFunc(GLenum sfactor, GLenum dfactor) {
+    RECORD(BLEND_FUNC, NULL, 0, sfactor, dfactor);
+    glBlendFunc(sfactor, dfactor);
+}
+
+void traceBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                          GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                          GLbitfield mask, GLenum filter) {
+    RECORD(BLIT_FRAMEBUFFER, NULL, 0, S(srcX0), S(srcY0), S(srcX1), S(srcY1),
+        S(dstX0), S(dstY0), S(dstX1), S(dstY1), mask, filter);
+    glBlitFramebuffer(srcX0, srcY0, srcX1, srcY1, dstX0, dstY0, dstX1, dstY1,
+        mask, filter);
+}
+
+void traceBufferData(GLenum target, GLsizeiptr size, const void *data,
+                     GLenum usage) {
+    RECORD(BUFFER_DATA, data, data ? size : 0, target, S(size), usage,
+        data != NULL);
+    glBufferData(target, size, data, usage);
+}
+
+void traceBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
+                        const void *data) {
+    RECORD(BUFFER_SUB_DATA, data, size, target, S(offset), S(size));
+    glBufferSubData(target, offset, size, data);
+}
+
+GLenum traceCheckFramebufferStatus(GLenum target) {
+    GLenum status = glCheckFramebufferStatus(target);
+    RECORD(CHECK_FRAMEBUFFER_STATUS, NULL, 0, target, status);
+    return status;
+}
+
+void traceClear(GLbitfield mask) {
+    RECORD(CLEAR, NULL, 0, mask);
+    glClear(mask);
+}
+
+void traceClearColor(GLfloat red, GLfloat green, GLfloat blue,
+                     GLfloat alpha) {
+    RECORD(CLEAR_COLOR, NULL, 0, floatBits(red), floatBits(green),
+        floatBits(blue), floatBits(alpha));
+    glClearColor(red, green, blue, alpha);
+}
+
+void traceColorMask(GLboolean red, GLboolean green, GLboolean blue,
+                    GLboolean alpha) {
+    RECORD(COLOR_MASK, NULL, 0, red, green, blue, alpha);
+    glColorMask(red, green, blue, alpha);
+}
+
+void traceCompileShader(GLuint shader) {
+    RECORD(COMPILE_SHADER, NULL, 0, shader);
+    glCompileShader(shader);
+}
+
+GLuint traceCreateProgram(void) {
+    GLuint program = glCreateProgram();
+    RECORD(CREATE_PROGRAM, NULL, 0, program);
+    return program;
+}
+
+GLuint traceCreateShader(GLenum type) {
+    GLuint shader = glCreateShader(type);
+    RECORD(CREATE_SHADER, NULL, 0, type, shader);
+    return shader;
+}
+
+void traceDeleteBuffers(GLsizei n, const GLuint *buffers) {
+    RECORD(DELETE_BUFFERS, buffers, n * sizeof(GLuint), S(n));
+    glDeleteBuffers(n, buffers);
+}
+
+void traceDeleteFramebuffers(GLsizei n, const GLuint *framebuffers) {
+    RECORD(DELETE_FRAMEBUFFERS, framebuffers, n * sizeof(GLuint), S(n));
+    glDeleteFramebuffers(n, framebuffers);
+}
+
+void traceDeleteProgram(GLuint program) {
+    RECORD(DELETE_PROGRAM, NULL, 0, program);
+    glDeleteProgram(program);
+}
+
+void traceDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers) {
+    RECORD(DELETE_RENDERBUFFERS, renderbuffers, n * sizeof(GLuint), S(n));
+    glDeleteRenderbuffers(n, renderbuffers);
+}
+
+void traceDeleteShader(GLuint shader) {
+    RECORD(DELETE_SHADER, NULL, 0, shader);
+    glDeleteShader(shader);
+}
+
+void traceDeleteTextures(GLsizei n, const GLuint *textures) {
+    RECORD(DELETE_TEXTURES, textures, n * sizeof(GLuint), S(n));
+    glDeleteTextures(n, textures);
+}
+
+void traceDepthFunc(GLenum func) {
+    RECORD(DEPTH_FUNC, NULL, 0, func);
+    glDepthFunc(func);
+}
+
+void traceDepthMask(GLboolean flag) {
+    RECORD(DEPTH_MASK, NULL, 0, flag);
+    glDepthMask(flag);
+}
+
+void traceDetachShader(GLuint program, GLuint shader) {
+    RECORD(DETACH_SHADER, NULL, 0, program, shader);
+    glDetachShader(program, shader);
+}
+
+void traceDisable(GLenum cap) {
+    RECORD(DISABLE, NULL, 0, cap);
+    glDisable(cap);
+}
+
+void traceDrawArrays(GLenum mode, GLint first, GLsizei count) {
+    RECORD(DRAW_ARRAYS, NULL, 0, mode, S(first), S(count));
+    glDrawArrays(mode, first, count);
+}
+
+void traceDrawArraysInstanced(GLenum mode, GLint first, GLsizei count,
+                              GLsizei instancecount) {
+    RECORD(DRAW_ARRAYS_INSTANCED, NULL, 0, mode, S(first), S(count),
+        S(instancecount));
+    glDrawArraysInstanced(mode, first, count, instancecount);
+}
+
+// indices is an offset into the bound element array buffer; indices in
+// client memory can't be replayed
+void traceDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                                const void *indices, GLsizei instancecount) {
+    RECORD(DRAW_ELEMENTS_INSTANCED, NULL, 0, mode, S(count), type,
+        (uint64_t)(uintptr_t)indices, S(instancecount));
+    glDrawElementsInstanced(mode, count, type, indices, instancecount);
+}
+
+void traceEnable(GLenum cap) {
+    RECORD(ENABLE, NULL, 0, cap);
+    glEnable(cap);
+}
+
+void traceEnableVertexAttribArray(GLuint index) {
+    RECORD(ENABLE_VERTEX_ATTRIB_ARRAY, NULL, 0, index);
+    glEnableVertexAttribArray(index);
+}
+
+void traceEndQuery(GLenum target) {
+    RECORD(END_QUERY, NULL, 0, target);
+    glEndQuery(target);
+}
+
+void traceEndTransformFeedback(void) {
+    // No arguments, which RECORD can't express in standard C
+    if (recording())
+        writeRecord(TRACE_END_TRANSFORM_FEEDBACK, NULL, 0, 0, NULL);
+    glEndTransformFeedback();
+}
+
+void traceFramebufferRenderbuffer(GLenum target, GLenum attachment,
+                                  GLenum renderbuffertarget,
+                                  GLuint renderbuffer) {
+    RECORD(FRAMEBUFFER_RENDERBUFFER, NULL, 0, target, attachment,
+        renderbuffertarget, renderbuffer);
+    glFramebufferRenderbuffer(target, attachment, renderbuffertarget,
+        renderbuffer);
+}
+
+void traceFramebufferTexture2D(GLenum target, GLenum attachment,
+                               GLenum textarget, GLuint texture, GLint level) {
+    RECORD(FRAMEBUFFER_TEXTURE_2D, NULL, 0, target, attachment, textarget,
+        texture, S(level));
+    glFramebufferTexture2D(target, attachment, textarget, texture, level);
+}
+
+// glGen* record the names they were given, so the replayer can map them
+void traceGenBuffers(GLsizei n, GLuint *buffers) {
+    glGenBuffers(n, buffers);
+    RECORD(GEN_BUFFERS, buffers, n * sizeof(GLuint), S(n));
+}
+
+void traceGenFramebuffers(GLsizei n, GLuint *framebuffers) {
+    glGenFramebuffers(n, framebuffers);
+    RECORD(GEN_FRAMEBUFFERS, framebuffers, n * sizeof(GLuint), S(n));
+}
+
+void traceGenQueries(GLsizei n, GLuint *ids) {
+    glGenQueries(n, ids);
+    RECORD(GEN_QUERIES, ids, n * sizeof(GLuint), S(n));
+}
+
+void traceGenRenderbuffers(GLsizei n, GLuint *renderbuffers) {
+    glGenRenderbuffers(n, renderbuffers);
+    RECORD(GEN_RENDERBUFFERS, renderbuffers, n * sizeof(GLuint), S(n));
+}
+
+void traceGenTextures(GLsizei n, GLuint *textures) {
+    glGenTextures(n, textures);
+    RECORD(GEN_TEXTURES, textures, n * sizeof(GLuint), S(n));
+}
+
+void traceGenVertexArrays(GLsizei n, GLuint *arrays) {
+    glGenVertexArrays(n, arrays);
+    RECORD(GEN_VERTEX_ARRAYS, arrays, n * sizeof(GLuint), S(n));
+}
+
+void traceGetIntegerv(GLenum pname, GLint *data) {
+    RECORD(GET_INTEGERV, NULL, 0, pname);
+    glGetIntegerv(pname, data);
+}
+
+void traceGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei *length,
+                            GLchar *infoLog) {
+    RECORD(GET_PROGRAM_INFO_LOG, NULL, 0, program, S(bufSize));
+    glGetProgramInfoLog(program, bufSize, length, infoLog);
+}
+
+void traceGetProgramiv(GLuint program, GLenum pname, GLint *params) {
+    RECORD(GET_PROGRAMIV, NULL, 0, program, pname);
+    glGetProgramiv(program, pname, params);
+}
+
+void traceGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params) {
+    RECORD(GET_QUERY_OBJECTUI64V, NULL, 0, id, pname);
+    glGetQueryObjectui64v(id, pname, params);
+}
+
+void traceGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei *length,
+                           GLchar *infoLog) {
+    RECORD(GET_SHADER_INFO_LOG, NULL, 0, shader, S(bufSize));
+    glGetShaderInfoLog(shader, bufSize, length, infoLog);
+}
+
+void traceGetShaderiv(GLuint shader, GLenum pname, GLint *params) {
+    RECORD(GET_SHADERIV, NULL, 0, shader, pname);
+    glGetShaderiv(shader, pname, params);
+}
+
+GLint traceGetUniformLocation(GLuint program, const GLchar *name) {
+    GLint location = glGetUniformLocation(program, name);
+    RECORD(GET_UNIFORM_LOCATION, name, strlen(name), program, S(location));
+    return location;
+}
+
+void traceLinkProgram(GLuint program) {
+    RECORD(LINK_PROGRAM, NULL, 0, program);
+    glLinkProgram(program);
+}
+
+void *traceMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
+                          GLbitfield access) {
+    if (!recording() || !(access & GL_MAP_WRITE_BIT))
+        return glMapBufferRange(target, offset, length, access);
+    if (traceMappingCount == GLTRACE_MAX_MAPPINGS) {
+        fputs("Too many buffers mapped at once to trace\n", stderr);
+        exit(1);
+    }
+
+    // The whole copy is written back at unmap, so explicit flushes don't
+    // matter. Unless the program is discarding the old contents, the copy
+    // has to start out holding them, which means reading the real mapping;
+    // that can't be unsynchronized.
+    access &= ~GL_MAP_FLUSH_EXPLICIT_BIT;
+    GLbitfield realAccess = access;
+    bool keep = !(access & (GL_MAP_INVALIDATE_RANGE_BIT |
+                            GL_MAP_INVALIDATE_BUFFER_BIT));
+    if (keep)
+        realAccess = (access & ~GL_MAP_UNSYNCHRONIZED_BIT) | GL_MAP_READ_BIT;
+    void *pointer = glMapBufferRange(target, offset, length, realAccess);
+    if (!pointer)
+        return NULL;
+
+    void *shadow = calloc(1, length ? length : 1);
+    if (!shadow) {
+        fputs("Failed to allocate a traced buffer mapping\n", stderr);
+        exit(1);
+    }
+    if (keep)
+        memcpy(shadow, pointer, length);
+    traceMappings[traceMappingCount++] = (struct TraceMapping){
+        target, offset, length, access, pointer, shadow};
+    return shadow;
+}
+
+void traceRenderbufferStorageMultisample(GLenum target, GLsizei samples,
+                                         GLenum internalformat, GLsizei width,
+                                         GLsizei height) {
+    RECORD(RENDERBUFFER_STORAGE_MULTISAMPLE, NULL, 0, target, S(samples),
+        internalformat, S(width), S(height));
+    glRenderbufferStorageMultisample(target, samples, internalformat, width,
+        height);
+}
+
+// The strings are joined into one payload; that compiles the same.
+void traceShaderSource(GLuint shader, GLsizei count,
+                       const GLchar *const *string, const GLint *length) {
+    if (recording()) {
+        size_t size = 0;
+        for (GLsizei i = 0; i < count; i++)
+            size += length && length[i] >= 0 ? (size_t)length[i]
+                                              : strlen(string[i]);
+        char *source = (char*)malloc(size ? size : 1);
+        if (!source) {
+            perror("Failed to allocate traced shader source");
+            exit(1);
+        }
+        size_t at = 0;
+        for (GLsizei i = 0; i < count; i++) {
+            size_t n = length && length[i] >= 0 ? (size_t)length[i]
+                                                : strlen(string[i]);
+            memcpy(source + at, string[i], n);
+            at += n;
+        }
+        RECORD(SHADER_SOURCE, source, size, shader);
+        free(source);
+    }
+    glShaderSource(shader, count, string, length);
+}
+
+void traceTexImage2D(GLenum target, GLint level, GLint internalformat,
+                     GLsizei width, GLsizei height, GLint border,
+                     GLenum format, GLenum type, const void *pixels) {
+    size_t size = pixels ? imageSize(width, height, format, type) : 0;
+    if (pixels && !size && recording())
+        fputs("Warning: can't trace texture data of this format; "
+              "replay will see an empty texture\n", stderr);
+    RECORD(TEX_IMAGE_2D, pixels, size, target, S(level), S(internalformat),
+        S(width), S(height), S(border), format, type, size != 0);
+    glTexImage2D(target, level, internalformat, width, height, border,
+        format, type, pixels);
+}
+
+void traceTexParameteri(GLenum target, GLenum pname, GLint param) {
+    RECORD(TEX_PARAMETERI, NULL, 0, target, pname, S(param));
+    glTexParameteri(target, pname, param);
+}
+
+// The names are the payload, each followed by its NUL
+void traceTransformFeedbackVaryings(GLuint program, GLsizei count,
+                                   const GLchar *const *varyings,
+                                   GLenum bufferMode) {
+    if (recording()) {
+        size_t size = 0;
+        for (GLsizei i = 0; i < count; i++)
+            size += strlen(varyings[i]) + 1;
+        char *names = (char*)malloc(size ? size : 1);
+        if (!names) {
+            perror("Failed to allocate traced varying names");
+            exit(1);
+        }
+        size_t at = 0;
+        for (GLsizei i = 0; i < count; i++) {
+            size_t n = strlen(varyings[i]) + 1;
+            memcpy(names + at, varyings[i], n);
+            at += n;
+        }
+        RECORD(TRANSFORM_FEEDBACK_VARYINGS, names, size, program, S(count),
+            bufferMode);
+        free(names);
+    }
+    glTransformFeedbackVaryings(program, count, varyings, bufferMode);
+}
+
+void traceUniform1f(GLint location, GLfloat v0) {
+    RECORD(UNIFORM_1F, NULL, 0, S(location), floatBits(v0));
+    glUniform1f(location, v0);
+}
+
+void traceUniform1i(GLint location, GLint v0) {
+    RECORD(UNIFORM_1I, NULL, 0, S(location), S(v0));
+    glUniform1i(location, v0);
+}
+
+void traceUniform2f(GLint location, GLfloat v0, GLfloat v1) {
+    RECORD(UNIFORM_2F, NULL, 0, S(location), floatBits(v0), floatBits(v1));
+    glUniform2f(location, v0, v1);
+}
+
+void traceUniform3fv(GLint location, GLsizei count, const GLfloat *value) {
+    RECORD(UNIFORM_3FV, value, count * 3 * sizeof(GLfloat), S(location),
+        S(count));
+    glUniform3fv(location, count, value);
+}
+
+void traceUniformMatrix4fv(GLint location, GLsizei count,
+                           GLboolean transpose, const GLfloat *value) {
+    RECORD(UNIFORM_MATRIX_4FV, value, count * 16 * sizeof(GLfloat),
+        S(location), S(count), transpose);
+    glUniformMatrix4fv(location, count, transpose, value);
+}
+
+// The bytes written while mapped are only known now
+GLboolean traceUnmapBuffer(GLenum target) {
+    for (int i = 0; i < traceMappingCount; i++) {
+        struct TraceMapping *m = &traceMappings[i];
+        if (m->target != target)
+            continue;
+        memcpy(m->pointer, m->shadow, m->length);
+        RECORD(MAP_BUFFER_RANGE, m->shadow, m->length, target, S(m->offset),
+            S(m->length), m->access);
+        free(m->shadow);
+        *m = traceMappings[--traceMappingCount];
+        break;
+    }
+    return glUnmapBuffer(target);
+}
+
+void traceUseProgram(GLuint program) {
+    RECORD(USE_PROGRAM, NULL, 0, program);
+    glUseProgram(program);
+}
+
+void traceVertexAttribDivisor(GLuint index, GLuint divisor) {
+    RECORD(VERTEX_ATTRIB_DIVISOR, NULL, 0, index, divisor);
+    glVertexAttribDivisor(index, divisor);
+}
+
+// With a VAO bound, the pointer is an offset into the buffer, so it's stored
+// as a number.
+void traceVertexAttribPointer(GLuint index, GLint size, GLenum type,
+                              GLboolean normalized, GLsizei stride,
+                              const void *pointer) {
+    RECORD(VERTEX_ATTRIB_POINTER, NULL, 0, index, S(size), type, normalized,
+        S(stride), (uint64_t)(uintptr_t)pointer);
+    glVertexAttribPointer(index, size, type, normalized, stride, pointer);
+}
+
+void traceViewport(GLint x, GLint y, GLsizei width, GLsizei height) {
+    RECORD(VIEWPORT, NULL, 0, S(x), S(y), S(width), S(height));
+    glViewport(x, y, width, height);
+}
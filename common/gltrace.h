@@ -0,0 +1,272 @@
+#ifndef GLTRACE_H
+#define GLTRACE_H
+
+// GL call recording. Include this after GL/glew.h and GLFW/glfw3.h, and link
+// with gltrace.o. From then on, every GL call the file makes (and the GLFW
+// calls that create the window and end each frame) goes through a wrapper in
+// gltrace.c.
+//
+// Run the program with GL_TRACE=file to record those calls, with everything
+// they read from memory, into that file. ../replay plays a trace back.
+// Without GL_TRACE, the wrappers just pass each call on.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void traceWindowHint(int hint, int value);
+GLFWwindow *traceCreateWindow(int width, int height, const char *title,
+                              GLFWmonitor *monitor, GLFWwindow *share);
+void traceSwapBuffers(GLFWwindow *window);
+
+void traceActiveTexture(GLenum texture);
+void traceAttachShader(GLuint program, GLuint shader);
+void traceBeginQuery(GLenum target, GLuint id);
+void traceBeginTransformFeedback(GLenum primitiveMode);
+void traceBindBuffer(GLenum target, GLuint buffer);
+void traceBindBufferBase(GLenum target, GLuint index, GLuint buffer);
+void traceBindFramebuffer(GLenum target, GLuint framebuffer);
+void traceBindRenderbuffer(GLenum target, GLuint renderbuffer);
+void traceBindTexture(GLenum target, GLuint texture);
+void traceBindVertexArray(GLuint array);
+void traceBlendFunc(GLenum sfactor, GLenum dfactor);
+void traceBlitFramebuffer(GLint srcX0, GLint srcY0, GLint srcX1, GLint srcY1,
+                          GLint dstX0, GLint dstY0, GLint dstX1, GLint dstY1,
+                          GLbitfield mask, GLenum filter);
+void traceBufferData(GLenum target, GLsizeiptr size, const void *data,
+                     GLenum usage);
+void traceBufferSubData(GLenum target, GLintptr offset, GLsizeiptr size,
+                        const void *data);
+GLenum traceCheckFramebufferStatus(GLenum target);
+void traceClear(GLbitfield mask);
+void traceClearColor(GLfloat red, GLfloat green, GLfloat blue, GLfloat alpha);
+void traceColorMask(GLboolean red, GLboolean green, GLboolean blue,
+                    GLboolean alpha);
+void traceCompileShader(GLuint shader);
+GLuint traceCreateProgram(void);
+GLuint traceCreateShader(GLenum type);
+void traceDeleteBuffers(GLsizei n, const GLuint *buffers);
+void traceDeleteFramebuffers(GLsizei n, const GLuint *framebuffers);
+void traceDeleteProgram(GLuint program);
+void traceDeleteRenderbuffers(GLsizei n, const GLuint *renderbuffers);
+void traceDeleteShader(GLuint shader);
+void traceDeleteTextures(GLsizei n, const GLuint *textures);
+void traceDepthFunc(GLenum func);
+void traceDepthMask(GLboolean flag);
+void traceDetachShader(GLuint program, GLuint shader);
+void traceDisable(GLenum cap);
+void traceDrawArrays(GLenum mode, GLint first, GLsizei count);
+void traceDrawArraysInstanced(GLenum mode, GLint first, GLsizei count,
+                              GLsizei instancecount);
+void traceDrawElementsInstanced(GLenum mode, GLsizei count, GLenum type,
+                                const void *indices, GLsizei instancecount);
+void traceEnable(GLenum cap);
+void traceEnableVertexAttribArray(GLuint index);
+void traceEndQuery(GLenum target);
+void traceEndTransformFeedback(void);
+void traceFramebufferRenderbuffer(GLenum target, GLenum attachment,
+                                  GLenum renderbuffertarget,
+                                  GLuint renderbuffer);
+void traceFramebufferTexture2D(GLenum target, GLenum attachment,
+                               GLenum textarget, GLuint texture, GLint level);
+void traceGenBuffers(GLsizei n, GLuint *buffers);
+void traceGenFramebuffers(GLsizei n, GLuint *framebuffers);
+void traceGenQueries(GLsizei n, GLuint *ids);
+void traceGenRenderbuffers(GLsizei n, GLuint *renderbuffers);
+void traceGenTextures(GLsizei n, GLuint *textures);
+void traceGenVertexArrays(GLsizei n, GLuint *arrays);
+void traceGetIntegerv(GLenum pname, GLint *data);
+void traceGetProgramInfoLog(GLuint program, GLsizei bufSize, GLsizei *length,
+                            GLchar *infoLog);
+void traceGetProgramiv(GLuint program, GLenum pname, GLint *params);
+void traceGetQueryObjectui64v(GLuint id, GLenum pname, GLuint64 *params);
+void traceGetShaderInfoLog(GLuint shader, GLsizei bufSize, GLsizei *length,
+                           GLchar *infoLog);
+void traceGetShaderiv(GLuint shader, GLenum pname, GLint *params);
+GLint traceGetUniformLocation(GLuint program, const GLchar *name);
+void traceLinkProgram(GLuint program);
+void *traceMapBufferRange(GLenum target, GLintptr offset, GLsizeiptr length,
+                          GLbitfield access);
+void traceRenderbufferStorageMultisample(GLenum target, GLsizei samples,
+                                         GLenum internalformat, GLsizei width,
+                                         GLsizei height);
+void traceShaderSource(GLuint shader, GLsizei count,
+                       const GLchar *const *string, const GLint *length);
+void traceTexImage2D(GLenum target, GLint level, GLint internalformat,
+                     GLsizei width, GLsizei height, GLint border,
+                     GLenum format, GLenum type, const void *pixels);
+void traceTexParameteri(GLenum target, GLenum pname, GLint param);
+void traceTransformFeedbackVaryings(GLuint program, GLsizei count,
+                                   const GLchar *const *varyings,
+                                   GLenum bufferMode);
+void traceUniform1f(GLint location, GLfloat v0);
+void traceUniform1i(GLint location, GLint v0);
+void traceUniform2f(GLint location, GLfloat v0, GLfloat v1);
+void traceUniform3fv(GLint location, GLsizei count, const GLfloat *value);
+void traceUniformMatrix4fv(GLint location, GLsizei count,
+                           GLboolean transpose, const GLfloat *value);
+GLboolean traceUnmapBuffer(GLenum target);
+void traceUseProgram(GLuint program);
+void traceVertexAttribDivisor(GLuint index, GLuint divisor);
+void traceVertexAttribPointer(GLuint index, GLint size, GLenum type,
+                              GLboolean normalized, GLsizei stride,
+                              const void *pointer);
+void traceViewport(GLint x, GLint y, GLsizei width, GLsizei height);
+
+#ifdef __cplusplus
+}
+#endif
+
+// gltrace.c itself calls the real functions
+#ifndef GLTRACE_IMPLEMENTATION
+
+#define glfwWindowHint traceWindowHint
+#define glfwCreateWindow traceCreateWindow
+#define glfwSwapBuffers traceSwapBuffers
+
+// GLEW defines most of these as macros already
+#undef glActiveTexture
+#undef glAttachShader
+#undef glBeginQuery
+#undef glBeginTransformFeedback
+#undef glBindBuffer
+#undef glBindBufferBase
+#undef glBindFramebuffer
+#undef glBindRenderbuffer
+#undef glBindTexture
+#undef glBindVertexArray
+#undef glBlendFunc
+#undef glBlitFramebuffer
+#undef glBufferData
+#undef glBufferSubData
+#undef glCheckFramebufferStatus
+#undef glClear
+#undef glClearColor
+#undef glColorMask
+#undef glCompileShader
+#undef glCreateProgram
+#undef glCreateShader
+#undef glDeleteBuffers
+#undef glDeleteFramebuffers
+#undef glDeleteProgram
+#undef glDeleteRenderbuffers
+#undef glDeleteShader
+#undef glDeleteTextures
+#undef glDepthFunc
+#undef glDepthMask
+#undef glDetachShader
+#undef glDisable
+#undef glDrawArrays
+#undef glDrawArraysInstanced
+#undef glDrawElementsInstanced
+#undef glEnable
+#undef glEnableVertexAttribArray
+#undef glEndQuery
+#undef glEndTransformFeedback
+#undef glFramebufferRenderbuffer
+#undef glFramebufferTexture2D
+#undef glGenBuffers
+#undef glGenFramebuffers
+#undef glGenQueries
+#undef glGenRenderbuffers
+#undef glGenTextures
+#undef glGenVertexArrays
+#undef glGetIntegerv
+#undef glGetProgramInfoLog
+#undef glGetProgramiv
+#undef glGetQueryObjectui64v
+#undef glGetShaderInfoLog
+#undef glGetShaderiv
+#undef glGetUniformLocation
+#undef glLinkProgram
+#undef glMapBufferRange
+#undef glRenderbufferStorageMultisample
+#undef glShaderSource
+#undef glTexImage2D
+#undef glTexParameteri
+#undef glTransformFeedbackVaryings
+#undef glUniform1f
+#undef glUniform1i
+#undef glUniform2f
+#undef glUniform3fv
+#undef glUniformMatrix4fv
+#undef glUnmapBuffer
+#undef glUseProgram
+#undef glVertexAttribDivisor
+#undef glVertexAttribPointer
+#undef glViewport
+
+#define glActiveTexture traceActiveTexture
+#define glAttachShader traceAttachShader
+#define glBeginQuery traceBeginQuery
+#define glBeginTransformFeedback traceBeginTransformFeedback
+#define glBindBuffer traceBindBuffer
+#define glBindBufferBase traceBindBufferBase
+#define glBindFramebuffer traceBindFramebuffer
+#define glBindRenderbuffer traceBindRenderbuffer
+#define glBindTexture traceBindTexture
+#define glBindVertexArray traceBindVertexArray
+#define glBlendFunc traceBlendFunc
+#define glBlitFramebuffer traceBlitFramebuffer
+#define glBufferData traceBufferData
+#define glBufferSubData traceBufferSubData
+#define glCheckFramebufferStatus traceCheckFramebufferStatus
+#define glClear traceClear
+#define glClearColor traceClearColor
+#define glColorMask traceColorMask
+#define glCompileShader traceCompileShader
+#define glCreateProgram traceCreateProgram
+#define glCreateShader traceCreateShader
+#define glDeleteBuffers traceDeleteBuffers
+#define glDeleteFramebuffers traceDeleteFramebuffers
+#define glDeleteProgram traceDeleteProgram
+#define glDeleteRenderbuffers traceDeleteRenderbuffers
+#define glDeleteShader traceDeleteShader
+#define glDeleteTextures traceDeleteTextures
+#define glDepthFunc traceDepthFunc
+#define glDepthMask traceDepthMask
+#define glDetachShader traceDetachShader
+#define glDisable traceDisable
+#define glDrawArrays traceDrawArrays
+#define glDrawArraysInstanced traceDrawArraysInstanced
+#define glDrawElementsInstanced traceDrawElementsInstanced
+#define glEnable traceEnable
+#define glEnableVertexAttribArray traceEnableVertexAttribArray
+#define glEndQuery traceEndQuery
+#define glEndTransformFeedback traceEndTransformFeedback
+#define glFramebufferRenderbuffer traceFramebufferRenderbuffer
+#define glFramebufferTexture2D traceFramebufferTexture2D
+#define glGenBuffers traceGenBuffers
+#define glGenFramebuffers traceGenFramebuffers
+#define glGenQueries traceGenQueries
+#define glGenRenderbuffers traceGenRenderbuffers
+#define glGenTextures traceGenTextures
+#define glGenVertexArrays traceGenVertexArrays
+#define glGetIntegerv traceGetIntegerv
+#define glGetProgramInfoLog traceGetProgramInfoLog
+#define glGetProgramiv traceGetProgramiv
+#define glGetQueryObjectui64v traceGetQueryObjectui64v
+#define glGetShaderInfoLog traceGetShaderInfoLog
+#define glGetShaderiv traceGetShaderiv
+#define glGetUniformLocation traceGetUniformLocation
+#define glLinkProgram traceLinkProgram
+#define glMapBufferRange traceMapBufferRange
+#define glRenderbufferStorageMultisample traceRenderbufferStorageMultisample
+#define glShaderSource traceShaderSource
+#define glTexImage2D traceTexImage2D
+#define glTexParameteri traceTexParameteri
+#define glTransformFeedbackVaryings traceTransformFeedbackVaryings
+#define glUniform1f traceUniform1f
+#define glUniform1i traceUniform1i
+#define glUniform2f traceUniform2f
+#define glUniform3fv traceUniform3fv
+#define glUniformMatrix4fv traceUniformMatrix4fv
+#define glUnmapBuffer traceUnmapBuffer
+#define glUseProgram traceUseProgram
+#define glVertexAttribDivisor traceVertexAttribDivisor
+#define glVertexAttribPointer traceVertexAttribPointer
+#define glViewport traceViewport
+
+#endif
+
+#endif
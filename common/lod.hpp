@@ -0,0 +1,455 @@
+#ifndef LOD_HPP
+#define LOD_HPP
+
+// Levels of detail: simpler versions of a shape, for when it's too small on
+// screen for the full one to make a visible difference.
+//
+// - simplifyMesh(): quadric error edge collapse (Garland and Heckbert), for
+//   triangle meshes. It's slow enough to be run at build time.
+// - simplifyDouglasPeucker() and simplifyVisvalingam(): for 2D polylines and
+//   polygon outlines, fast enough to run at startup for each zoom level.
+//   simplificationError() measures how far the result strays.
+// - selectLod(): picks the level to draw from how big each level's error
+//   would be on screen, with hysteresis so that an object sitting near a
+//   threshold doesn't flick between levels.
+//
+// Every level carries its error: roughly how far, in the shape's own units,
+// it strays from the full shape. Errors grow from level 0, the full shape.
+
+#include <math.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <queue>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Which level to draw, given each level's error, how many pixels one unit of
+// error covers now, and the level drawn last time. The coarsest level whose
+// error is at most threshold pixels is wanted, but moving to a coarser level
+// than the current one needs the error to be below threshold * (1 -
+// hysteresis). Moving finer happens straight away, so quality never waits.
+inline int selectLod(const float *errors, int count, float pixelsPerUnit,
+                     float threshold, float hysteresis, int current) {
+    int wanted = 0;
+    while (wanted + 1 < count && errors[wanted + 1] * pixelsPerUnit
+                                 <= threshold)
+        wanted++;
+    if (wanted <= current)
+        return wanted;
+
+    float stricter = threshold * (1 - hysteresis);
+    int level = current;
+    while (level < wanted && errors[level + 1] * pixelsPerUnit <= stricter)
+        level++;
+    return level;
+}
+
+// Pixels covered by one unit at distance from a perspective camera with the
+// given vertical field of view, viewportHeight pixels high
+inline float pixelsPerUnit(float distance, float fovY, float viewportHeight) {
+    return viewportHeight / (2 * tanf(fovY / 2) * distance);
+}
+
+struct LodMesh {
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices; // 3 per triangle
+};
+
+struct MeshLevel {
+    LodMesh mesh;
+    float error;
+};
+
+// The sum of squared distances to a set of planes, as a symmetric 4x4 matrix
+struct Quadric {
+    // aa ab ac ad bb bc bd cc cd dd
+    double q[10] = {};
+    // Total weight of the planes, to turn error() into a mean distance
+    double weight = 0;
+
+    void addPlane(double a, double b, double c, double d, double weight) {
+        const double p[4] = {a, b, c, d};
+        int k = 0;
+        for (int i = 0; i < 4; i++)
+            for (int j = i; j < 4; j++)
+                q[k++] += weight * p[i] * p[j];
+        this->weight += weight;
+    }
+
+    Quadric &operator+=(const Quadric &other) {
+        for (int k = 0; k < 10; k++)
+            q[k] += other.q[k];
+        weight += other.weight;
+        return *this;
+    }
+
+    double error(glm::vec3 v) const {
+        double x = v.x, y = v.y, z = v.z;
+        return q[0]*x*x + 2*q[1]*x*y + 2*q[2]*x*z + 2*q[3]*x
+             + q[4]*y*y + 2*q[5]*y*z + 2*q[6]*y
+             + q[7]*z*z + 2*q[8]*z
+             + q[9];
+    }
+
+    // The point with the least error, if there's a single one
+    bool minimum(glm::vec3 &v) const {
+        double a = q[0], b = q[1], c = q[2], d = q[4], e = q[5], f = q[7];
+        double det = a*(d*f - e*e) - b*(b*f - c*e) + c*(b*e - c*d);
+        if (fabs(det) < 1e-12)
+            return false;
+        double r0 = -q[3], r1 = -q[6], r2 = -q[8];
+        // Cramer's rule
+        v.x = (float)((r0*(d*f - e*e) - b*(r1*f - e*r2) + c*(r1*e - d*r2))
+                      / det);
+        v.y = (float)((a*(r1*f - e*r2) - r0*(b*f - c*e) + c*(b*r2 - r1*c))
+                      / det);
+        v.z = (float)((a*(d*r2 - r1*e) - b*(b*r2 - r1*c) + r0*(b*e - c*d))
+                      / det);
+        return true;
+    }
+};
+
+// Simplify a triangle mesh by collapsing its cheapest edge, over and over,
+// and keep a copy each time the triangle count reaches the next of
+// targetTriangles (largest first). The mesh needs shared vertices: welded
+// seams, not separate copies per triangle.
+inline std::vector<MeshLevel> simplifyMesh(
+        const LodMesh &mesh, const std::vector<size_t> &targetTriangles) {
+    struct Collapse {
+        double cost;
+        float distance; // Mean distance from the planes merged so far
+        uint32_t u, v;
+        uint32_t uVersion, vVersion;
+        glm::vec3 position;
+
+        bool operator<(const Collapse &other) const {
+            return cost > other.cost; // Cheapest first
+        }
+    };
+
+    std::vector<glm::vec3> positions = mesh.positions;
+    std::vector<uint32_t> tris = mesh.indices;
+    size_t vertexCount = positions.size(), triCount = tris.size() / 3;
+
+    std::vector<Quadric> quadrics(vertexCount);
+    std::vector<std::vector<uint32_t>> vertexTris(vertexCount);
+    std::vector<uint32_t> version(vertexCount, 0);
+    std::vector<bool> vertexAlive(vertexCount, true),
+                      triAlive(triCount, true);
+
+    auto normal = [&](uint32_t t, uint32_t moved, glm::vec3 to) {
+        glm::vec3 p[3];
+        for (int k = 0; k < 3; k++) {
+            uint32_t i = tris[t*3 + k];
+            p[k] = i == moved ? to : positions[i];
+        }
+        return glm::cross(p[1] - p[0], p[2] - p[0]);
+    };
+
+    // Each vertex starts with the planes of the triangles around it,
+    // weighted by area so slivers don't count for much
+    for (size_t t = 0; t < triCount; t++) {
+        glm::vec3 n = normal(t, ~0u, glm::vec3(0));
+        float area2 = glm::length(n);
+        for (int k = 0; k < 3; k++)
+            vertexTris[tris[t*3 + k]].push_back(t);
+        if (area2 <= 0)
+            continue;
+        n /= area2;
+        double d = -glm::dot(n, positions[tris[t*3]]);
+        for (int k = 0; k < 3; k++)
+            quadrics[tris[t*3 + k]].addPlane(n.x, n.y, n.z, d, area2 / 2);
+    }
+
+    std::priority_queue<Collapse> heap;
+    auto push = [&](uint32_t u, uint32_t v) {
+        Quadric q = quadrics[u];
+        q += quadrics[v];
+        glm::vec3 p;
+        if (!q.minimum(p)) {
+            // Flat or along a crease: take the best of the ends and middle
+            glm::vec3 options[3] = {positions[u], positions[v],
+                                    (positions[u] + positions[v]) * 0.5f};
+            p = options[0];
+            for (glm::vec3 o: options)
+                if (q.error(o) < q.error(p))
+                    p = o;
+        }
+        double cost = std::max(q.error(p), 0.0);
+        float distance = q.weight > 0 ? (float)sqrt(cost / q.weight) : 0;
+        heap.push({cost, distance, u, v, version[u], version[v], p});
+    };
+    for (size_t t = 0; t < triCount; t++)
+        for (int k = 0; k < 3; k++) {
+            uint32_t u = tris[t*3 + k], v = tris[t*3 + (k + 1) % 3];
+            if (u < v)
+                push(u, v);
+        }
+
+    auto snapshot = [&](float error) {
+        MeshLevel level;
+        level.error = error;
+        std::vector<uint32_t> remap(vertexCount, ~0u);
+        for (size_t t = 0; t < triCount; t++) {
+            if (!triAlive[t])
+                continue;
+            for (int k = 0; k < 3; k++) {
+                uint32_t &i = remap[tris[t*3 + k]];
+                if (i == ~0u) {
+                    i = level.mesh.positions.size();
+                    level.mesh.positions.push_back(positions[tris[t*3 + k]]);
+                }
+                level.mesh.indices.push_back(i);
+            }
+        }
+        return level;
+    };
+
+    std::vector<MeshLevel> levels;
+    size_t target = 0, trisLeft = triCount;
+    float worst = 0;
+    std::vector<uint32_t> neighbours;
+    while (target < targetTriangles.size()) {
+        if (trisLeft <= targetTriangles[target] || heap.empty()) {
+            levels.push_back(snapshot(worst));
+            target++;
+            continue;
+        }
+
+        Collapse c = heap.top();
+        heap.pop();
+        if (!vertexAlive[c.u] || !vertexAlive[c.v]
+            || version[c.u] != c.uVersion || version[c.v] != c.vVersion)
+            continue; // Out of date
+
+        // Don't fold any triangle over: each that survives must keep facing
+        // roughly the same way
+        bool flips = false;
+        for (uint32_t moved: {c.u, c.v})
+            for (uint32_t t: vertexTris[moved]) {
+                const uint32_t *i = &tris[t*3];
+                bool shared = (i[0] == c.u || i[1] == c.u || i[2] == c.u)
+                           && (i[0] == c.v || i[1] == c.v || i[2] == c.v);
+                if (!triAlive[t] || shared)
+                    continue;
+                glm::vec3 before = normal(t, ~0u, glm::vec3(0)),
+                          after = normal(t, moved, c.position);
+                if (glm::dot(before, after) <= 0)
+                    flips = true;
+            }
+        if (flips)
+            continue;
+
+        // Move u to the new position and hand it v's triangles; the ones
+        // that had both are gone
+        positions[c.u] = c.position;
+        quadrics[c.u] += quadrics[c.v];
+        for (uint32_t t: vertexTris[c.v]) {
+            if (!triAlive[t])
+                continue;
+            uint32_t *i = &tris[t*3];
+            if (i[0] == c.u || i[1] == c.u || i[2] == c.u) {
+                triAlive[t] = false;
+                trisLeft--;
+                continue;
+            }
+            for (int k = 0; k < 3; k++)
+                if (i[k] == c.v)
+                    i[k] = c.u;
+            vertexTris[c.u].push_back(t);
+        }
+        vertexAlive[c.v] = false;
+        vertexTris[c.v].clear();
+        std::vector<uint32_t> &uTris = vertexTris[c.u];
+        uTris.erase(std::remove_if(uTris.begin(), uTris.end(),
+            [&](uint32_t t) { return !triAlive[t]; }), uTris.end());
+        version[c.u]++;
+        worst = std::max(worst, c.distance);
+
+        // Every edge around u costs something different now
+        neighbours.clear();
+        for (uint32_t t: uTris)
+            for (int k = 0; k < 3; k++)
+                if (tris[t*3 + k] != c.u)
+                    neighbours.push_back(tris[t*3 + k]);
+        std::sort(neighbours.begin(), neighbours.end());
+        neighbours.erase(std::unique(neighbours.begin(), neighbours.end()),
+            neighbours.end());
+        for (uint32_t n: neighbours)
+            push(c.u, n);
+    }
+    return levels;
+}
+
+// Distance from p to the segment a-b
+inline float segmentDistance(glm::vec2 p, glm::vec2 a, glm::vec2 b) {
+    glm::vec2 ab = b - a;
+    float lengthSquared = glm::dot(ab, ab);
+    float t = lengthSquared > 0
+            ? glm::clamp(glm::dot(p - a, ab) / lengthSquared, 0.f, 1.f) : 0;
+    return glm::length(p - (a + ab * t));
+}
+
+// How far a line strays from a simplification of it that kept some of its
+// points, in order: the furthest any dropped point is from the simplified
+// line. Between points, the full line can't stray further than that.
+inline float simplificationError(const std::vector<glm::vec2> &points,
+                                 const std::vector<glm::vec2> &simplified,
+                                 bool closed) {
+    size_t n = points.size(), m = simplified.size();
+    if (!n || !m)
+        return 0;
+    // A closed outline's simplification needn't start where it does
+    size_t i = 0;
+    while (i < n && points[i] != simplified[0])
+        i++;
+    if (i == n)
+        return 0;
+
+    float worst = 0;
+    size_t segments = closed ? m : m - 1;
+    for (size_t j = 0; j < segments; j++) {
+        glm::vec2 a = simplified[j], b = simplified[(j + 1) % m];
+        // The points dropped between a and b, stopping after one lap in case
+        // b isn't there
+        size_t k = (i + 1) % n;
+        for (size_t steps = 0; points[k] != b && steps < n; steps++) {
+            worst = std::max(worst, segmentDistance(points[k], a, b));
+            k = (k + 1) % n;
+        }
+        i = k;
+    }
+    return worst;
+}
+
+// Keep the fewest points such that none dropped is further than tolerance
+// from the simplified line. A closed outline is split at the point furthest
+// from its first one, and each half simplified like a polyline.
+inline std::vector<glm::vec2> simplifyDouglasPeucker(
+        const std::vector<glm::vec2> &points, float tolerance, bool closed) {
+    size_t n = points.size();
+    if (n < 3)
+        return points;
+
+    std::vector<bool> keep(n, false);
+    std::vector<std::pair<size_t, size_t>> stack;
+    keep[0] = true;
+    if (closed) {
+        size_t far = 1;
+        for (size_t i = 2; i < n; i++)
+            if (glm::length(points[i] - points[0])
+                > glm::length(points[far] - points[0]))
+                far = i;
+        keep[far] = true;
+        stack.push_back({0, far});
+        // Back round to the start; index n stands for point 0
+        stack.push_back({far, n});
+    } else {
+        keep[n - 1] = true;
+        stack.push_back({0, n - 1});
+    }
+
+    while (!stack.empty()) {
+        size_t first = stack.back().first, last = stack.back().second;
+        stack.pop_back();
+        glm::vec2 a = points[first], b = points[last % n];
+        float worst = 0;
+        size_t worstIndex = 0;
+        for (size_t i = first + 1; i < last; i++) {
+            float d = segmentDistance(points[i], a, b);
+            if (d > worst) {
+                worst = d;
+                worstIndex = i;
+            }
+        }
+        if (worst > tolerance) {
+            keep[worstIndex] = true;
+            stack.push_back({first, worstIndex});
+            stack.push_back({worstIndex, last});
+        }
+    }
+
+    std::vector<glm::vec2> result;
+    for (size_t i = 0; i < n; i++)
+        if (keep[i])
+            result.push_back(points[i]);
+    return result;
+}
+
+// Drop points one at a time, always the one whose triangle with its two
+// neighbours has the least area, until every point left makes a triangle of
+// at least minArea. A point's area never counts as less than that of a point
+// already dropped, so the order stays sensible as neighbours change.
+inline std::vector<glm::vec2> simplifyVisvalingam(
+        const std::vector<glm::vec2> &points, float minArea, bool closed) {
+    size_t n = points.size();
+    size_t least = closed ? 3 : 2;
+    if (n <= least)
+        return points;
+
+    std::vector<size_t> prev(n), next(n);
+    std::vector<float> area(n);
+    std::vector<uint32_t> version(n, 0);
+    std::vector<bool> removed(n, false);
+    for (size_t i = 0; i < n; i++) {
+        prev[i] = i ? i - 1 : n - 1;
+        next[i] = i + 1 < n ? i + 1 : 0;
+    }
+    auto triangleArea = [&](size_t i) {
+        glm::vec2 a = points[prev[i]], b = points[i], c = points[next[i]];
+        return fabsf((b.x - a.x) * (c.y - a.y) - (c.x - a.x) * (b.y - a.y))
+               / 2;
+    };
+
+    struct Entry {
+        float area;
+        size_t index;
+        uint32_t version;
+
+        bool operator<(const Entry &other) const {
+            return area > other.area; // Smallest first
+        }
+    };
+    std::priority_queue<Entry> heap;
+    for (size_t i = 0; i < n; i++) {
+        // The ends of an open line stay
+        if (!closed && (i == 0 || i == n - 1))
+            continue;
+        area[i] = triangleArea(i);
+        heap.push({area[i], i, 0});
+    }
+
+    size_t left = n;
+    float floor = 0;
+    while (!heap.empty() && left > least) {
+        Entry e = heap.top();
+        heap.pop();
+        if (removed[e.index] || e.version != version[e.index])
+            continue;
+        if (e.area >= minArea)
+            break;
+
+        floor = std::max(floor, e.area);
+        removed[e.index] = true;
+        left--;
+        size_t p = prev[e.index], q = next[e.index];
+        next[p] = q;
+        prev[q] = p;
+        for (size_t i: {p, q}) {
+            if (!closed && (i == 0 || i == n - 1))
+                continue;
+            area[i] = std::max(triangleArea(i), floor);
+            heap.push({area[i], i, ++version[i]});
+        }
+    }
+
+    std::vector<glm::vec2> result;
+    for (size_t i = 0; i < n; i++)
+        if (!removed[i])
+            result.push_back(points[i]);
+    return result;
+}
+
+#endif
@@ -0,0 +1,273 @@
+#ifndef MEMORY_HPP
+#define MEMORY_HPP
+
+// Memory for the render loop, so that drawing a frame never goes to the heap:
+//
+// - FrameArena: a linear allocator for data that only lives for a frame or
+//   two (draw lists, culling results, instance data). Allocating bumps a
+//   pointer; nothing is freed until the whole arena is reset.
+// - DoubleBufferedArena: two FrameArenas used on alternate frames, so last
+//   frame's data is still intact while this frame's is built.
+// - Pool: fixed-size slots for long-lived objects of one type, such as scene
+//   nodes, with a free list for reuse.
+// - FrameVector: a std::pmr::vector, for containers that allocate from an
+//   arena instead of the heap.
+//
+// To check that the loop really stays off the heap, define
+// COUNT_HEAP_ALLOCATIONS in exactly one source file before including this.
+// That replaces the global operator new (plain, aligned and nothrow; the
+// array forms call these) to count calls, and a NoHeapAllocations guard then
+// fails loudly if anything allocated while it was alive. Only C++
+// allocations are counted; the GL driver and C libraries go straight to
+// malloc. The count is for the whole process, so an allocation on another
+// thread while a guard is alive trips it too.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <atomic>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Number of times the global operator new has been called on any thread, if
+// counting
+inline std::atomic<size_t> heapAllocationCount(0);
+
+#ifdef COUNT_HEAP_ALLOCATIONS
+// Everything comes from malloc or aligned_alloc, so every delete is free()
+static void *countedAllocate(size_t size, size_t alignment) {
+    heapAllocationCount++;
+    if (!size)
+        size = 1;
+    if (alignment <= alignof(max_align_t))
+        return malloc(size);
+    // aligned_alloc wants a whole number of alignments
+    return aligned_alloc(alignment, (size + alignment - 1) & ~(alignment - 1));
+}
+
+void *operator new(size_t size) {
+    if (void *p = countedAllocate(size, 0))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new(size_t size, std::align_val_t alignment) {
+    if (void *p = countedAllocate(size, (size_t)alignment))
+        return p;
+    throw std::bad_alloc();
+}
+void *operator new(size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size, 0);
+}
+void *operator new(size_t size, std::align_val_t alignment,
+                   const std::nothrow_t&) noexcept {
+    return countedAllocate(size, (size_t)alignment);
+}
+
+void operator delete(void *p) noexcept {
+    free(p);
+}
+void operator delete(void *p, size_t) noexcept {
+    free(p);
+}
+void operator delete(void *p, std::align_val_t) noexcept {
+    free(p);
+}
+void operator delete(void *p, size_t, std::align_val_t) noexcept {
+    free(p);
+}
+void operator delete(void *p, const std::nothrow_t&) noexcept {
+    free(p);
+}
+void operator delete(void *p, std::align_val_t,
+                     const std::nothrow_t&) noexcept {
+    free(p);
+}
+#endif
+
+// Fails, naming where, if anything allocated on the heap between its
+// construction and destruction.
+class NoHeapAllocations {
+public:
+    explicit NoHeapAllocations(const char *where):
+        where(where), start(heapAllocationCount) {}
+
+    ~NoHeapAllocations() {
+        size_t allocations = heapAllocationCount - start;
+        if (allocations) {
+            fprintf(stderr, "%zu heap allocation(s) in %s\n", allocations,
+                where);
+            abort();
+        }
+    }
+
+private:
+    const char *where;
+    size_t start;
+};
+
+class FrameArena: public std::pmr::memory_resource {
+public:
+    // The whole capacity is allocated now. Running out later means the
+    // capacity is too small for the scene, which is a bug, so it's fatal.
+    explicit FrameArena(size_t capacity):
+        base((unsigned char*)malloc(capacity)), capacity(capacity) {
+        if (!base) {
+            perror("Failed to allocate frame arena");
+            exit(1);
+        }
+    }
+    ~FrameArena() {
+        free(base);
+    }
+    FrameArena(const FrameArena&) = delete;
+    FrameArena &operator=(const FrameArena&) = delete;
+
+    // Forget everything allocated so far
+    void reset() {
+        used = 0;
+    }
+
+    size_t bytesUsed() const {
+        return used;
+    }
+    // The most that has been in use at once since the arena was made
+    size_t peakBytesUsed() const {
+        return peak;
+    }
+    size_t bytesCapacity() const {
+        return capacity;
+    }
+
+private:
+    void *do_allocate(size_t bytes, size_t alignment) override {
+        size_t start = (used + alignment - 1) & ~(alignment - 1);
+        if (start + bytes > capacity) {
+            fprintf(stderr, "Frame arena out of memory: %zu bytes wanted, "
+                "%zu of %zu used\n", bytes, used, capacity);
+            exit(1);
+        }
+        used = start + bytes;
+        if (used > peak)
+            peak = used;
+        return base + start;
+    }
+
+    // Memory only comes back when the whole arena is reset
+    void do_deallocate(void*, size_t, size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource &other)
+        const noexcept override {
+        return this == &other;
+    }
+
+    unsigned char *base;
+    size_t capacity, used = 0, peak = 0;
+};
+
+// Two arenas used on alternate frames. Starting a frame resets only the arena
+// that was used the frame before last, so anything still referring to last
+// frame's data (such as an upload that hasn't happened yet) stays valid.
+class DoubleBufferedArena {
+public:
+    explicit DoubleBufferedArena(size_t capacityEach):
+        arenas{FrameArena(capacityEach), FrameArena(capacityEach)} {}
+
+    // Switch to the other arena, empty it, and return it
+    FrameArena &beginFrame() {
+        current ^= 1;
+        arenas[current].reset();
+        return arenas[current];
+    }
+
+    FrameArena &thisFrame() {
+        return arenas[current];
+    }
+    FrameArena &lastFrame() {
+        return arenas[current ^ 1];
+    }
+
+    size_t peakBytesUsed() const {
+        size_t a = arenas[0].peakBytesUsed(), b = arenas[1].peakBytesUsed();
+        return a > b ? a : b;
+    }
+
+private:
+    FrameArena arenas[2];
+    int current = 0;
+};
+
+// A vector whose storage comes from the given memory resource, such as a
+// FrameArena. Reserve up front: growing it leaves the old storage unused in
+// the arena until the next reset.
+template <typename T>
+using FrameVector = std::pmr::vector<T>;
+
+// Fixed-size slots for up to capacity objects of type T. Creating and
+// destroying them just pops and pushes a free list; nothing is allocated
+// after construction.
+template <typename T>
+class Pool {
+public:
+    explicit Pool(size_t capacity):
+        slots((Slot*)malloc(capacity * sizeof(Slot))), capacity(capacity) {
+        if (!slots) {
+            perror("Failed to allocate pool");
+            exit(1);
+        }
+        for (size_t i = 0; i < capacity; i++)
+            slots[i].next = i + 1 < capacity ? &slots[i + 1] : NULL;
+        freeList = capacity ? slots : NULL;
+    }
+    // Objects still alive aren't destroyed; only their memory goes
+    ~Pool() {
+        free(slots);
+    }
+    Pool(const Pool&) = delete;
+    Pool &operator=(const Pool&) = delete;
+
+    template <typename... Args>
+    T *create(Args&&... args) {
+        if (!freeList) {
+            fprintf(stderr, "Pool of %zu objects is full\n", capacity);
+            exit(1);
+        }
+        Slot *slot = freeList;
+        freeList = slot->next;
+        if (++live > peak)
+            peak = live;
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T *object) {
+        object->~T();
+        Slot *slot = (Slot*)object;
+        slot->next = freeList;
+        freeList = slot;
+        live--;
+    }
+
+    size_t liveCount() const {
+        return live;
+    }
+    size_t peakCount() const {
+        return peak;
+    }
+    size_t countCapacity() const {
+        return capacity;
+    }
+
+private:
+    union Slot {
+        Slot *next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    Slot *slots, *freeList;
+    size_t capacity, live = 0, peak = 0;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#ifndef STARTUP_TIME_H
+#define STARTUP_TIME_H
+
+// Measures how long a tutorial takes from being started to presenting its
+// first frame. Call markMainStart() first thing in main(), and
+// reportStartupTime() after every glfwSwapBuffers(); it only prints once.
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+static struct timespec mainStartTime;
+
+static inline double secondsSince(const struct timespec *from) {
+    struct timespec now;
+    timespec_get(&now, TIME_UTC);
+    return (now.tv_sec - from->tv_sec) + (now.tv_nsec - from->tv_nsec) * 1e-9;
+}
+
+static inline void markMainStart(void) {
+    timespec_get(&mainStartTime, TIME_UTC);
+}
+
+// Seconds since the process was exec'd, including dynamic linking and static
+// initialisation, or -1 where that can't be found out. The kernel only keeps
+// these times to the nearest clock tick (usually 10 ms).
+static inline double secondsSinceExec(void) {
+#ifdef __linux__
+    // The start time is the 22nd field of stat, in ticks since boot. It comes
+    // after the command name, which may contain spaces but ends with ')'.
+    char line[1024];
+    FILE *f = fopen("/proc/self/stat", "r");
+    if (!f)
+        return -1;
+    size_t n = fread(line, 1, sizeof(line) - 1, f);
+    fclose(f);
+    line[n] = '\0';
+    char *field = strrchr(line, ')');
+    unsigned long long startTicks;
+    if (!field || sscanf(field + 2,
+            "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d "
+            "%*d %*d %*d %*d %llu", &startTicks) != 1)
+        return -1;
+
+    // Seconds since boot, on the same clock
+    double uptime;
+    f = fopen("/proc/uptime", "r");
+    if (!f)
+        return -1;
+    int read = fscanf(f, "%lf", &uptime);
+    fclose(f);
+    if (read != 1)
+        return -1;
+
+    return uptime - (double)startTicks / sysconf(_SC_CLK_TCK);
+#else
+    return -1;
+#endif
+}
+
+static inline void reportStartupTime(void) {
+    static bool reported = false;
+    if (reported)
+        return;
+    reported = true;
+
+    double sinceMain = secondsSince(&mainStartTime),
+           sinceExec = secondsSinceExec();
+    if (sinceExec >= 0)
+        printf("First frame presented %.0f ms after exec "
+               "(%.1f ms after main)\n", 1e3 * sinceExec, 1e3 * sinceMain);
+    else
+        printf("First frame presented %.1f ms after main\n", 1e3 * sinceMain);
+}
+
+#endif
@@ -0,0 +1,700 @@
+// Plays back a GL trace recorded by ../common/gltrace.c, as fast as it can,
+// and reports how long each kind of call and each frame took. The same trace
+// replays the same calls every time, so it makes a repeatable benchmark of
+// the session it was recorded from; replaying part of it narrows down where
+// a slow frame comes from.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <GL/glew.h>
+#include <GLFW/glfw3.h>
+
+#include "../common/gltrace-format.h"
+
+#define GLTRACE_NAME(name) #name,
+static const char *const opNames[TRACE_OP_COUNT] = {
+    GLTRACE_OPS(GLTRACE_NAME)
+};
+#undef GLTRACE_NAME
+
+struct Record {
+    TraceOp op;
+    uint64_t args[GLTRACE_MAX_ARGS]; // Missing ones are 0
+    size_t payloadOffset, payloadSize;
+    const void *payload;
+};
+
+// Each kind of GL object has its own names
+enum Namespace {
+    NAMES_BUFFERS,
+    NAMES_FRAMEBUFFERS,
+    NAMES_QUERIES,
+    NAMES_RENDERBUFFERS,
+    NAMES_TEXTURES,
+    NAMES_VERTEX_ARRAYS,
+    NAMES_PROGRAMS, // Shaders and programs share names
+    NAMESPACE_COUNT
+};
+
+static struct {
+    std::vector<Record> records;
+    // Payloads, each starting 8-byte aligned so uniform data can be passed
+    // straight to GL
+    std::vector<unsigned char> payloads;
+    // Index of the SWAP_BUFFERS record that ends each frame
+    std::vector<size_t> frameEnds;
+} trace;
+
+static struct {
+    // Recorded object name -> the name the replay got
+    std::unordered_map<GLuint, GLuint> names[NAMESPACE_COUNT];
+    // (recorded program, recorded location) -> replayed location
+    std::unordered_map<uint64_t, GLint> uniforms;
+    GLuint program; // Recorded name of the program in use
+    int mismatches; // Results that differed from the recording
+    std::vector<GLint> ints;
+    std::vector<GLchar> chars;
+} state;
+
+static struct {
+    uint64_t calls[TRACE_OP_COUNT];
+    double seconds[TRACE_OP_COUNT];
+    std::vector<double> frameSeconds;
+} timing;
+
+static void glfwErrorCallback(int error, const char *desc) {
+    fprintf(stderr, "GLFW error 0x%08X: %s\n", error, desc);
+}
+
+static bool readVarint(const unsigned char *&at, const unsigned char *end,
+                       uint64_t &value) {
+    value = 0;
+    for (int shift = 0; at < end && shift < 64; shift += 7) {
+        unsigned char byte = *at++;
+        value |= (uint64_t)(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+static void readTrace(const char *fn) {
+    FILE *f = fopen(fn, "rb");
+    if (!f) {
+        perror(fn);
+        exit(1);
+    }
+    std::vector<unsigned char> data;
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)))
+        data.insert(data.end(), buf, buf + n);
+    if (ferror(f)) {
+        perror(fn);
+        exit(1);
+    }
+    fclose(f);
+
+    size_t headerSize = strlen(GLTRACE_MAGIC) + 1;
+    if (data.size() < headerSize
+        || memcmp(data.data(), GLTRACE_MAGIC, headerSize - 1)) {
+        fprintf(stderr, "%s is not a GL trace\n", fn);
+        exit(1);
+    }
+    if (data[headerSize - 1] != GLTRACE_VERSION) {
+        fprintf(stderr, "%s is trace format version %d; this reads %d\n", fn,
+            data[headerSize - 1], GLTRACE_VERSION);
+        exit(1);
+    }
+
+    // A program that was killed may have left its last record unfinished;
+    // replay everything up to it.
+    const unsigned char *at = data.data() + headerSize,
+                        *end = data.data() + data.size();
+    while (at < end) {
+        const unsigned char *start = at;
+        Record r = {};
+        bool complete = end - at >= 2;
+        int argc = 0;
+        if (complete) {
+            r.op = (TraceOp)*at++;
+            argc = *at++;
+            if (r.op >= TRACE_OP_COUNT || argc > GLTRACE_MAX_ARGS) {
+                fprintf(stderr, "%s: bad record at offset %zu\n", fn,
+                    (size_t)(start - data.data()));
+                exit(1);
+            }
+        }
+        for (int i = 0; complete && i < argc; i++)
+            complete = readVarint(at, end, r.args[i]);
+        uint64_t size = 0;
+        complete = complete && readVarint(at, end, size)
+                   && size <= (uint64_t)(end - at);
+        if (!complete) {
+            fprintf(stderr, "Warning: %s ends with an incomplete record\n",
+                fn);
+            break;
+        }
+
+        r.payloadOffset = trace.payloads.size();
+        r.payloadSize = size;
+        trace.payloads.insert(trace.payloads.end(), at, at + size);
+        trace.payloads.resize((trace.payloads.size() + 7) & ~(size_t)7);
+        at += size;
+
+        if (r.op == TRACE_SWAP_BUFFERS)
+            trace.frameEnds.push_back(trace.records.size());
+        trace.records.push_back(r);
+    }
+    for (Record &r: trace.records)
+        r.payload = trace.payloads.data() + r.payloadOffset;
+}
+
+// The context is made from the recorded hints, but never shown, so the
+// replay doesn't depend on a window being on screen.
+static void init() {
+    glfwSetErrorCallback(glfwErrorCallback);
+
+    if (!glfwInit()) {
+        fprintf(stderr, "Failed to initialize GLFW\n");
+        exit(1);
+    }
+
+    size_t i = 0;
+    for (; i < trace.records.size()
+           && trace.records[i].op == TRACE_WINDOW_HINT; i++)
+        glfwWindowHint((int)trace.records[i].args[0],
+            (int)trace.records[i].args[1]);
+    if (i == trace.records.size()
+        || trace.records[i].op != TRACE_CREATE_WINDOW) {
+        fputs("The trace doesn't start by creating a window.\n", stderr);
+        exit(1);
+    }
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+
+    GLFWwindow *window = glfwCreateWindow((int)trace.records[i].args[0],
+        (int)trace.records[i].args[1], "replay", NULL, NULL);
+    if (!window) {
+        fputs("Failed to create a GL context for the trace.\n", stderr);
+        glfwTerminate();
+        exit(1);
+    }
+    glfwMakeContextCurrent(window);
+
+    glewExperimental = true; // Needed in core profile
+    if (glewInit() != GLEW_OK) {
+        fprintf(stderr, "Failed to initialize GLEW\n");
+        glfwTerminate();
+        exit(1);
+    }
+}
+
+static GLuint mapName(Namespace ns, uint64_t recorded) {
+    if (!recorded)
+        return 0;
+    auto found = state.names[ns].find((GLuint)recorded);
+    if (found == state.names[ns].end()) {
+        fprintf(stderr, "Trace uses %s name %u it never created\n",
+            ns == NAMES_PROGRAMS ? "shader/program" : "object",
+            (GLuint)recorded);
+        exit(1);
+    }
+    return found->second;
+}
+
+static GLint mapUniform(uint64_t recorded) {
+    GLint location = (GLint)(int64_t)recorded;
+    if (location < 0)
+        return location;
+    auto found = state.uniforms.find((uint64_t)state.program << 32
+                                     | (uint32_t)location);
+    return found == state.uniforms.end() ? location : found->second;
+}
+
+typedef void (GLAPIENTRY *GenFunction)(GLsizei, GLuint*);
+typedef void (GLAPIENTRY *DeleteFunction)(GLsizei, const GLuint*);
+
+static void gen(GenFunction fn, Namespace ns, const Record &r) {
+    GLsizei n = (GLsizei)r.args[0];
+    std::vector<GLuint> names(n);
+    fn(n, names.data());
+    const GLuint *recorded = (const GLuint*)r.payload;
+    for (GLsizei i = 0; i < n; i++)
+        state.names[ns][recorded[i]] = names[i];
+}
+
+static void del(DeleteFunction fn, Namespace ns, const Record &r) {
+    GLsizei n = (GLsizei)r.args[0];
+    std::vector<GLuint> names(n);
+    const GLuint *recorded = (const GLuint*)r.payload;
+    for (GLsizei i = 0; i < n; i++) {
+        names[i] = mapName(ns, recorded[i]);
+        state.names[ns].erase(recorded[i]);
+    }
+    fn(n, names.data());
+}
+
+static GLfloat asFloat(uint64_t bits) {
+    uint32_t b = (uint32_t)bits;
+    GLfloat value;
+    memcpy(&value, &b, sizeof(value));
+    return value;
+}
+
+static GLint *ints(size_t n) {
+    if (state.ints.size() < n)
+        state.ints.resize(n);
+    return state.ints.data();
+}
+
+static GLchar *chars(size_t n) {
+    if (state.chars.size() < n)
+        state.chars.resize(n);
+    return state.chars.data();
+}
+
+static void execute(const Record &r) {
+    const uint64_t *a = r.args;
+    const GLfloat *floats = (const GLfloat*)r.payload;
+    // Shorthands for the common argument types
+    #define E(i) ((GLenum)a[i])
+    // Sizes and offsets are cast straight from a[i] instead, since they can
+    // pass 2 GiB
+    #define I(i) ((GLint)(int64_t)a[i])
+    #define U(i) ((GLuint)a[i])
+    #define F(i) asFloat(a[i])
+
+    switch (r.op) {
+    case TRACE_WINDOW_HINT:
+    case TRACE_CREATE_WINDOW:
+        break; // Handled by init()
+    case TRACE_SWAP_BUFFERS:
+        // Finish the frame's work, so it's timed, but don't wait for vsync
+        glFinish();
+        break;
+    case TRACE_ACTIVE_TEXTURE:
+        glActiveTexture(E(0));
+        break;
+    case TRACE_ATTACH_SHADER:
+        glAttachShader(mapName(NAMES_PROGRAMS, a[0]),
+            mapName(NAMES_PROGRAMS, a[1]));
+        break;
+    case TRACE_BEGIN_QUERY:
+        glBeginQuery(E(0), mapName(NAMES_QUERIES, a[1]));
+        break;
+    case TRACE_BEGIN_TRANSFORM_FEEDBACK:
+        glBeginTransformFeedback(E(0));
+        break;
+    case TRACE_BIND_BUFFER:
+        glBindBuffer(E(0), mapName(NAMES_BUFFERS, a[1]));
+        break;
+    case TRACE_BIND_BUFFER_BASE:
+        glBindBufferBase(E(0), U(1), mapName(NAMES_BUFFERS, a[2]));
+        break;
+    case TRACE_BIND_FRAMEBUFFER:
+        glBindFramebuffer(E(0), mapName(NAMES_FRAMEBUFFERS, a[1]));
+        break;
+    case TRACE_BIND_RENDERBUFFER:
+        glBindRenderbuffer(E(0), mapName(NAMES_RENDERBUFFERS, a[1]));
+        break;
+    case TRACE_BIND_TEXTURE:
+        glBindTexture(E(0), mapName(NAMES_TEXTURES, a[1]));
+        break;
+    case TRACE_BIND_VERTEX_ARRAY:
+        glBindVertexArray(mapName(NAMES_VERTEX_ARRAYS, a[0]));
+        break;
+    case TRACE_BLEND_FUNC:
+        glBlendFunc(E(0), E(1));
+        break;
+    case TRACE_BLIT_FRAMEBUFFER:
+        glBlitFramebuffer(I(0), I(1), I(2), I(3), I(4), I(5), I(6), I(7),
+            U(8), E(9));
+        break;
+    case TRACE_BUFFER_DATA:
+        glBufferData(E(0), (GLsizeiptr)a[1], a[3] ? r.payload : NULL, E(2));
+        break;
+    case TRACE_BUFFER_SUB_DATA:
+        glBufferSubData(E(0), (GLintptr)a[1], (GLsizeiptr)a[2], r.payload);
+        break;
+    case TRACE_CHECK_FRAMEBUFFER_STATUS:
+        if (glCheckFramebufferStatus(E(0)) != E(1)) {
+            fprintf(stderr, "Warning: framebuffer status differs from the "
+                "recording\n");
+            state.mismatches++;
+        }
+        break;
+    case TRACE_CLEAR:
+        glClear(U(0));
+        break;
+    case TRACE_CLEAR_COLOR:
+        glClearColor(F(0), F(1), F(2), F(3));
+        break;
+    case TRACE_COLOR_MASK:
+        glColorMask(U(0), U(1), U(2), U(3));
+        break;
+    case TRACE_COMPILE_SHADER: {
+        GLuint shader = mapName(NAMES_PROGRAMS, a[0]);
+        glCompileShader(shader);
+        GLint status;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+        if (!status) {
+            fprintf(stderr, "Warning: a traced shader doesn't compile here\n");
+            state.mismatches++;
+        }
+        break;
+    }
+    case TRACE_CREATE_PROGRAM:
+        state.names[NAMES_PROGRAMS][U(0)] = glCreateProgram();
+        break;
+    case TRACE_CREATE_SHADER:
+        state.names[NAMES_PROGRAMS][U(1)] = glCreateShader(E(0));
+        break;
+    case TRACE_DELETE_BUFFERS:
+        del(glDeleteBuffers, NAMES_BUFFERS, r);
+        break;
+    case TRACE_DELETE_FRAMEBUFFERS:
+        del(glDeleteFramebuffers, NAMES_FRAMEBUFFERS, r);
+        break;
+    case TRACE_DELETE_PROGRAM:
+        glDeleteProgram(mapName(NAMES_PROGRAMS, a[0]));
+        break;
+    case TRACE_DELETE_RENDERBUFFERS:
+        del(glDeleteRenderbuffers, NAMES_RENDERBUFFERS, r);
+        break;
+    case TRACE_DELETE_SHADER:
+        glDeleteShader(mapName(NAMES_PROGRAMS, a[0]));
+        break;
+    case TRACE_DELETE_TEXTURES:
+        del(glDeleteTextures, NAMES_TEXTURES, r);
+        break;
+    case TRACE_DEPTH_FUNC:
+        glDepthFunc(E(0));
+        break;
+    case TRACE_DEPTH_MASK:
+        glDepthMask(U(0));
+        break;
+    case TRACE_DETACH_SHADER:
+        glDetachShader(mapName(NAMES_PROGRAMS, a[0]),
+            mapName(NAMES_PROGRAMS, a[1]));
+        break;
+    case TRACE_DISABLE:
+        glDisable(E(0));
+        break;
+    case TRACE_DRAW_ARRAYS:
+        glDrawArrays(E(0), I(1), I(2));
+        break;
+    case TRACE_DRAW_ARRAYS_INSTANCED:
+        glDrawArraysInstanced(E(0), I(1), I(2), I(3));
+        break;
+    case TRACE_DRAW_ELEMENTS_INSTANCED:
+        glDrawElementsInstanced(E(0), I(1), E(2), (const void*)(uintptr_t)a[3],
+            I(4));
+        break;
+    case TRACE_ENABLE:
+        glEnable(E(0));
+        break;
+    case TRACE_ENABLE_VERTEX_ATTRIB_ARRAY:
+        glEnableVertexAttribArray(U(0));
+        break;
+    case TRACE_END_QUERY:
+        glEndQuery(E(0));
+        break;
+    case TRACE_END_TRANSFORM_FEEDBACK:
+        glEndTransformFeedback();
+        break;
+    case TRACE_FRAMEBUFFER_RENDERBUFFER:
+        glFramebufferRenderbuffer(E(0), E(1), E(2),
+            mapName(NAMES_RENDERBUFFERS, a[3]));
+        break;
+    case TRACE_FRAMEBUFFER_TEXTURE_2D:
+        glFramebufferTexture2D(E(0), E(1), E(2),
+            mapName(NAMES_TEXTURES, a[3]), I(4));
+        break;
+    case TRACE_GEN_BUFFERS:
+        gen(glGenBuffers, NAMES_BUFFERS, r);
+        break;
+    case TRACE_GEN_FRAMEBUFFERS:
+        gen(glGenFramebuffers, NAMES_FRAMEBUFFERS, r);
+        break;
+    case TRACE_GEN_QUERIES:
+        gen(glGenQueries, NAMES_QUERIES, r);
+        break;
+    case TRACE_GEN_RENDERBUFFERS:
+        gen(glGenRenderbuffers, NAMES_RENDERBUFFERS, r);
+        break;
+    case TRACE_GEN_TEXTURES:
+        gen(glGenTextures, NAMES_TEXTURES, r);
+        break;
+    case TRACE_GEN_VERTEX_ARRAYS:
+        gen(glGenVertexArrays, NAMES_VERTEX_ARRAYS, r);
+        break;
+    // Gets are replayed too, since they can stall just as they did when
+    // recording; what they return doesn't matter here.
+    case TRACE_GET_INTEGERV:
+        glGetIntegerv(E(0), ints(16));
+        break;
+    case TRACE_GET_PROGRAM_INFO_LOG:
+        glGetProgramInfoLog(mapName(NAMES_PROGRAMS, a[0]), I(1), NULL,
+            chars(I(1)));
+        break;
+    case TRACE_GET_PROGRAMIV:
+        glGetProgramiv(mapName(NAMES_PROGRAMS, a[0]), E(1), ints(1));
+        break;
+    case TRACE_GET_QUERY_OBJECTUI64V: {
+        GLuint64 result;
+        glGetQueryObjectui64v(mapName(NAMES_QUERIES, a[0]), E(1), &result);
+        break;
+    }
+    case TRACE_GET_SHADER_INFO_LOG:
+        glGetShaderInfoLog(mapName(NAMES_PROGRAMS, a[0]), I(1), NULL,
+            chars(I(1)));
+        break;
+    case TRACE_GET_SHADERIV:
+        glGetShaderiv(mapName(NAMES_PROGRAMS, a[0]), E(1), ints(1));
+        break;
+    case TRACE_GET_UNIFORM_LOCATION: {
+        std::string name((const char*)r.payload, r.payloadSize);
+        GLint location = glGetUniformLocation(mapName(NAMES_PROGRAMS, a[0]),
+            name.c_str());
+        if (I(1) >= 0)
+            state.uniforms[a[0] << 32 | (uint32_t)I(1)] = location;
+        if ((I(1) < 0) != (location < 0)) {
+            fprintf(stderr, "Warning: uniform %s is %s here\n", name.c_str(),
+                location < 0 ? "missing" : "present but wasn't recorded");
+            state.mismatches++;
+        }
+        break;
+    }
+    case TRACE_LINK_PROGRAM: {
+        GLuint program = mapName(NAMES_PROGRAMS, a[0]);
+        glLinkProgram(program);
+        GLint status;
+        glGetProgramiv(program, GL_LINK_STATUS, &status);
+        if (!status) {
+            fprintf(stderr, "Warning: a traced program doesn't link here\n");
+            state.mismatches++;
+        }
+        break;
+    }
+    case TRACE_MAP_BUFFER_RANGE: {
+        void *mapped = glMapBufferRange(E(0), (GLintptr)a[1],
+            (GLsizeiptr)a[2], U(3));
+        if (!mapped) {
+            fputs("Failed to map a traced buffer range\n", stderr);
+            exit(1);
+        }
+        memcpy(mapped, r.payload, r.payloadSize);
+        if (!glUnmapBuffer(E(0))) {
+            fputs("Warning: a traced buffer's contents were lost\n", stderr);
+            state.mismatches++;
+        }
+        break;
+    }
+    case TRACE_RENDERBUFFER_STORAGE_MULTISAMPLE:
+        glRenderbufferStorageMultisample(E(0), I(1), E(2), I(3), I(4));
+        break;
+    case TRACE_SHADER_SOURCE: {
+        const GLchar *source = (const GLchar*)r.payload;
+        GLint length = (GLint)r.payloadSize;
+        glShaderSource(mapName(NAMES_PROGRAMS, a[0]), 1, &source, &length);
+        break;
+    }
+    case TRACE_TEX_IMAGE_2D:
+        glTexImage2D(E(0), I(1), I(2), I(3), I(4), I(5), E(6), E(7),
+            a[8] ? r.payload : NULL);
+        break;
+    case TRACE_TEX_PARAMETERI:
+        glTexParameteri(E(0), E(1), I(2));
+        break;
+    case TRACE_TRANSFORM_FEEDBACK_VARYINGS: {
+        // The payload is the names, each ending in a NUL
+        std::vector<const GLchar*> names;
+        const char *name = (const char*)r.payload,
+                   *end = name + r.payloadSize;
+        for (int i = 0; i < I(1) && name < end; i++) {
+            names.push_back(name);
+            name += strlen(name) + 1;
+        }
+        glTransformFeedbackVaryings(mapName(NAMES_PROGRAMS, a[0]),
+            names.size(), names.data(), E(2));
+        break;
+    }
+    case TRACE_UNIFORM_1F:
+        glUniform1f(mapUniform(a[0]), F(1));
+        break;
+    case TRACE_UNIFORM_1I:
+        glUniform1i(mapUniform(a[0]), I(1));
+        break;
+    case TRACE_UNIFORM_2F:
+        glUniform2f(mapUniform(a[0]), F(1), F(2));
+        break;
+    case TRACE_UNIFORM_3FV:
+        glUniform3fv(mapUniform(a[0]), I(1), floats);
+        break;
+    case TRACE_UNIFORM_MATRIX_4FV:
+        glUniformMatrix4fv(mapUniform(a[0]), I(1), U(2), floats);
+        break;
+    case TRACE_USE_PROGRAM:
+        glUseProgram(mapName(NAMES_PROGRAMS, a[0]));
+        state.program = U(0);
+        break;
+    case TRACE_VERTEX_ATTRIB_DIVISOR:
+        glVertexAttribDivisor(U(0), U(1));
+        break;
+    case TRACE_VERTEX_ATTRIB_POINTER:
+        glVertexAttribPointer(U(0), I(1), E(2), U(3), I(4),
+            (const void*)(uintptr_t)a[5]);
+        break;
+    case TRACE_VIEWPORT:
+        glViewport(I(0), I(1), I(2), I(3));
+        break;
+    case TRACE_OP_COUNT:
+        break;
+    }
+
+    #undef E
+    #undef I
+    #undef U
+    #undef F
+}
+
+// Replays records [begin, end) without timing them
+static void run(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++)
+        execute(trace.records[i]);
+}
+
+// Replays records [begin, end), timing each call, and each frame from the
+// end of the one before
+static void runTimed(size_t begin, size_t end) {
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point frameStart = Clock::now();
+    for (size_t i = begin; i < end; i++) {
+        const Record &r = trace.records[i];
+        Clock::time_point start = Clock::now();
+        execute(r);
+        Clock::time_point finish = Clock::now();
+        timing.calls[r.op]++;
+        timing.seconds[r.op] +=
+            std::chrono::duration<double>(finish - start).count();
+        if (r.op == TRACE_SWAP_BUFFERS) {
+            timing.frameSeconds.push_back(
+                std::chrono::duration<double>(finish - frameStart).count());
+            frameStart = finish;
+        }
+    }
+}
+
+static void report(const char *framesFn) {
+    int order[TRACE_OP_COUNT];
+    for (int op = 0; op < TRACE_OP_COUNT; op++)
+        order[op] = op;
+    std::sort(order, order + TRACE_OP_COUNT, [](int a, int b) {
+        return timing.seconds[a] > timing.seconds[b];
+    });
+
+    double total = 0;
+    for (int op = 0; op < TRACE_OP_COUNT; op++)
+        total += timing.seconds[op];
+    printf("\n%-34s %10s %10s %9s %6s\n", "call", "count", "total ms",
+        "us/call", "%");
+    for (int op: order) {
+        if (!timing.calls[op])
+            continue;
+        printf("%-34s %10llu %10.2f %9.3f %5.1f%%\n", opNames[op],
+            (unsigned long long)timing.calls[op], timing.seconds[op] * 1e3,
+            timing.seconds[op] * 1e6 / timing.calls[op],
+            100 * timing.seconds[op] / total);
+    }
+
+    std::vector<double> &frames = timing.frameSeconds;
+    if (!frames.empty()) {
+        std::vector<double> sorted = frames;
+        std::sort(sorted.begin(), sorted.end());
+        double sum = 0;
+        for (double s: frames)
+            sum += s;
+        printf("\n%zu frames: min %.3f ms, median %.3f ms, avg %.3f ms, "
+            "max %.3f ms\n", frames.size(), sorted.front() * 1e3,
+            sorted[sorted.size() / 2] * 1e3, sum / frames.size() * 1e3,
+            sorted.back() * 1e3);
+    }
+
+    if (framesFn) {
+        FILE *f = fopen(framesFn, "w");
+        if (!f) {
+            perror(framesFn);
+            exit(1);
+        }
+        for (double s: frames)
+            fprintf(f, "%.6f\n", s * 1e3);
+        if (fclose(f)) {
+            perror(framesFn);
+            exit(1);
+        }
+    }
+}
+
+static void usage() {
+    fputs("Usage: replay [-s first] [-n frames] [-l loops] [-o times] trace\n"
+          "  Replays a trace recorded with GL_TRACE=trace, timing frames\n"
+          "  first to first+frames-1 (default all of them) loops times.\n"
+          "  Earlier frames are replayed untimed to set up state; later ones\n"
+          "  aren't replayed. -o writes each timed frame's ms to times.\n",
+        stderr);
+    exit(1);
+}
+
+int main(int argc, char **argv) {
+    long first = 0, count = -1, loops = 1;
+    const char *framesFn = NULL;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:n:l:o:")) != -1) {
+        switch (opt) {
+        case 's': first = atol(optarg); break;
+        case 'n': count = atol(optarg); break;
+        case 'l': loops = atol(optarg); break;
+        case 'o': framesFn = optarg; break;
+        default: usage();
+        }
+    }
+    if (optind != argc - 1 || first < 0 || count == 0 || loops < 1)
+        usage();
+
+    readTrace(argv[optind]);
+    long frames = (long)trace.frameEnds.size();
+    printf("%zu calls in %ld frames\n", trace.records.size(), frames);
+    if (first >= frames) {
+        fprintf(stderr, "The trace only has %ld frames\n", frames);
+        return 1;
+    }
+    if (count < 0 || first + count > frames)
+        count = frames - first;
+
+    init();
+
+    // Frame i is everything after frame i-1's SWAP_BUFFERS, up to its own
+    size_t begin = first ? trace.frameEnds[first - 1] + 1 : 0,
+           end = trace.frameEnds[first + count - 1] + 1;
+    run(0, begin);
+    for (long loop = 0; loop < loops; loop++)
+        runTimed(begin, end);
+
+    report(framesFn);
+    if (state.mismatches)
+        printf("%d result(s) differed from the recording\n",
+            state.mismatches);
+
+    glfwTerminate();
+    return 0;
+}